@@ -0,0 +1,63 @@
+/*
+  SimpleXlsxWriter
+  Copyright (C) 2012-2021 Pavel Akimov <oxod.pavel@gmail.com>, Alexandr Belyak <programmeralex@bk.ru>
+
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef XLSX_BYTEHASH_HPP
+#define XLSX_BYTEHASH_HPP
+
+#include <cstddef>
+#include <cstring>
+
+#include <stdint.h>
+
+namespace SimpleXlsx
+{
+
+//Hash of the byte strings for the hash tables of the library (shared strings, styles)
+class ByteHash
+{
+    public:
+        //64-bit hash of the bytes, processes 8 bytes per step. Tables use its low bits for the slots.
+        static inline uint64_t Bytes( const char * Str, size_t Len )
+        {
+            const uint64_t Mul = 0x9E3779B97F4A7C15ULL;
+            uint64_t Result = Len * Mul;
+            for( ; Len >= 8; Str += 8, Len -= 8 )
+            {
+                uint64_t Word;
+                std::memcpy( & Word, Str, 8 );
+                Result = ( Result ^ Word ) * Mul;
+                Result ^= Result >> 29;
+            }
+            if( Len > 0 )
+            {
+                uint64_t Word = 0;
+                std::memcpy( & Word, Str, Len );
+                Result = ( Result ^ Word ) * Mul;
+            }
+            Result ^= Result >> 32;
+            Result *= 0xD6E8FEB86659FD93ULL;
+            return Result ^ ( Result >> 32 );
+        }
+};
+
+}
+
+#endif // XLSX_BYTEHASH_HPP
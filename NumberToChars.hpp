@@ -0,0 +1,228 @@
+/*
+  SimpleXlsxWriter
+  Copyright (C) 2012-2021 Pavel Akimov <oxod.pavel@gmail.com>, Alexandr Belyak <programmeralex@bk.ru>
+
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef XLSX_NUMBERTOCHARS_HPP
+#define XLSX_NUMBERTOCHARS_HPP
+
+#include <clocale>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <stdint.h>
+
+#if defined( __has_include )
+#if __has_include( <charconv> ) && ( ( __cplusplus >= 201703L ) || ( defined( _MSVC_LANG ) && ( _MSVC_LANG >= 201703L ) ) )
+#include <charconv>
+#endif
+#endif
+
+#if defined( __cpp_lib_to_chars ) && ( __cpp_lib_to_chars >= 201611L )
+#define SIMPLE_XLSX_USE_TO_CHARS
+#endif
+
+namespace SimpleXlsx
+{
+
+//Locale independent conversion of numbers to the XML text representation
+class NumberToChars
+{
+    public:
+        static const size_t BufferSize = 32;    //Enough for any value written by the functions below
+        static const int MaxPrecision = 17;     //Significant digits that read back any double exactly, limit for Precision()
+        static const int MaxDecimals = 9;       //Limit of the digits after the point for Fixed()
+
+        //All functions write to the Buffer (without '\0') and return the number of characters
+        static inline size_t UInt( uint64_t Value, char * Buffer )
+        {
+            const size_t Len = DigitCount( Value );
+            char * Ptr = Buffer + Len;
+            while( Value >= 100 )   //Two digits per step
+            {
+                const size_t Pair = static_cast< size_t >( Value % 100 ) * 2;
+                Value /= 100;
+                Ptr -= 2;
+                std::memcpy( Ptr, DigitPairs() + Pair, 2 );
+            }
+            if( Value >= 10 )
+                std::memcpy( Ptr - 2, DigitPairs() + Value * 2, 2 );
+            else * ( Ptr - 1 ) = static_cast< char >( '0' + Value );
+            return Len;
+        }
+
+        static inline size_t Int( int64_t Value, char * Buffer )
+        {
+            if( Value >= 0 )
+                return UInt( static_cast< uint64_t >( Value ), Buffer );
+            * Buffer = '-';
+            return UInt( 0ULL - static_cast< uint64_t >( Value ), Buffer + 1 ) + 1;
+        }
+
+        //The shortest text that is read back to exactly the same double
+        static inline size_t Double( double Value, char * Buffer )
+        {
+            if( IsExactInteger( Value, 9007199254740992.0 ) )  //2^53
+                return Int( static_cast< int64_t >( Value ), Buffer );
+            //Short decimal fractions (prices, readings): the first k that gives back the same value is the shortest text
+            const double Abs = std::fabs( Value );
+            if( ( Abs >= 1e-3 ) && ( Abs < 1e9 ) )
+            {
+                for( int k = 1; k <= 6; k++ )
+                {
+                    const double Units = std::round( Value * Pow10( k ) );
+                    if( Units / Pow10( k ) == Value )   //Both are exact, the division is rounded as the reading of the text
+                        return Scaled( static_cast< int64_t >( Units ), k, Buffer );
+                }
+            }
+#ifdef SIMPLE_XLSX_USE_TO_CHARS
+            return std::to_chars( Buffer, Buffer + BufferSize, Value ).ptr - Buffer;
+#else
+            return RoundTrip( Value, Buffer, 15, 17, false );
+#endif
+        }
+
+        //Value rounded to Decimals (0 to MaxDecimals) digits after the point (half away from zero), the trailing zeros
+        //are not written. The values that do not fit 2^53 units of the last digit are written by Double().
+        static inline size_t Fixed( double Value, int Decimals, char * Buffer )
+        {
+            Decimals = Decimals < 0 ? 0 : ( Decimals > MaxDecimals ? MaxDecimals : Decimals );
+            const double Units = std::round( Value * Pow10( Decimals ) );
+            if( !( ( Units > -9007199254740992.0 ) && ( Units < 9007199254740992.0 ) ) )  //Also NaN
+                return Double( Value, Buffer );
+            return Scaled( static_cast< int64_t >( Units ), Decimals, Buffer );
+        }
+
+        //The shortest text that is read back to exactly the same float
+        static inline size_t Float( float Value, char * Buffer )
+        {
+            if( IsExactInteger( Value, 16777216.0 ) )  //2^24
+                return Int( static_cast< int64_t >( Value ), Buffer );
+#ifdef SIMPLE_XLSX_USE_TO_CHARS
+            return std::to_chars( Buffer, Buffer + BufferSize, Value ).ptr - Buffer;
+#else
+            return RoundTrip( Value, Buffer, 6, 9, true );
+#endif
+        }
+
+        //printf-like "%.*g" with the given number of significant digits (MaxPrecision at most)
+        static inline size_t Precision( double Value, int Digits, char * Buffer )
+        {
+            if( Digits > MaxPrecision )
+                Digits = MaxPrecision;
+            return Print( Value, Digits, Buffer );
+        }
+
+    private:
+        static inline double Pow10( int Exp )
+        {
+            static const double Powers[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9 };
+            return Powers[ Exp ];
+        }
+
+        //Writes Units * 10^-Decimals in the fixed-point notation without the trailing zeros
+        static inline size_t Scaled( int64_t Units, int Decimals, char * Buffer )
+        {
+            for( ; ( Decimals > 0 ) && ( Units % 10 == 0 ); Decimals-- )
+                Units /= 10;
+            if( Decimals == 0 )
+                return Int( Units, Buffer );
+            char * Ptr = Buffer;
+            if( Units < 0 )
+                * Ptr++ = '-';
+            char Digits[ BufferSize ];
+            const size_t Len = UInt( Units < 0 ? 0ULL - static_cast< uint64_t >( Units ) : static_cast< uint64_t >( Units ), Digits );
+            const size_t Frac = static_cast< size_t >( Decimals );
+            if( Len > Frac )
+            {
+                std::memcpy( Ptr, Digits, Len - Frac );
+                Ptr += Len - Frac;
+            }
+            else * Ptr++ = '0';
+            * Ptr++ = '.';
+            for( size_t i = Len; i < Frac; i++ )
+                * Ptr++ = '0';
+            const size_t FracLen = Len > Frac ? Frac : Len;
+            std::memcpy( Ptr, Digits + Len - FracLen, FracLen );
+            return static_cast< size_t >( Ptr - Buffer ) + FracLen;
+        }
+
+        static inline const char * DigitPairs()
+        {
+            static const char Pairs[] =
+                "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+                "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+                "8081828384858687888990919293949596979899";
+            return Pairs;
+        }
+
+        static inline size_t DigitCount( uint64_t Value )
+        {
+            size_t Len = 1;
+            for( ; Value >= 10000; Value /= 10000 )
+                Len += 4;
+            if( Value >= 1000 ) return Len + 3;
+            if( Value >= 100 ) return Len + 2;
+            if( Value >= 10 ) return Len + 1;
+            return Len;
+        }
+
+        static inline bool IsExactInteger( double Value, double Limit )
+        {
+            return ( Value > -Limit ) && ( Value < Limit ) && ( static_cast< double >( static_cast< int64_t >( Value ) ) == Value );
+        }
+
+        static inline size_t Print( double Value, int Digits, char * Buffer )
+        {
+            char Tmp[ 64 ];
+            const int Len = snprintf( Tmp, sizeof( Tmp ), "%.*g", Digits, Value );
+            if( ( Len <= 0 ) || ( Len >= static_cast< int >( BufferSize ) ) )
+                return 0;
+            const char DecimalPoint = * localeconv()->decimal_point;  //Output must not depend on the global C locale
+            for( int i = 0; i < Len; i++ )
+                Buffer[ i ] = ( Tmp[ i ] == DecimalPoint ) ? '.' : Tmp[ i ];
+            return static_cast< size_t >( Len );
+        }
+
+#ifndef SIMPLE_XLSX_USE_TO_CHARS
+        //Increases the number of significant digits until the text is read back to the same value
+        static inline size_t RoundTrip( double Value, char * Buffer, int MinDigits, int MaxDigits, bool AsFloat )
+        {
+            size_t Len = 0;
+            for( int Digits = MinDigits; Digits <= MaxDigits; Digits++ )
+            {
+                char Tmp[ 64 ];
+                snprintf( Tmp, sizeof( Tmp ), "%.*g", Digits, Value );
+                const double Back = strtod( Tmp, NULL );    //Same locale as snprintf
+                if( ( Digits == MaxDigits ) || ( AsFloat ? ( static_cast< float >( Back ) == static_cast< float >( Value ) ) : ( Back == Value ) ) )
+                {
+                    Len = Print( Value, Digits, Buffer );
+                    break;
+                }
+            }
+            return Len;
+        }
+#endif
+};
+
+}
+
+#endif // XLSX_NUMBERTOCHARS_HPP
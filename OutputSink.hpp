@@ -0,0 +1,188 @@
+/*
+  SimpleXlsxWriter
+  Copyright (C) 2012-2021 Pavel Akimov <oxod.pavel@gmail.com>, Alexandr Belyak <programmeralex@bk.ru>
+
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef XLSX_OUTPUTSINK_HPP
+#define XLSX_OUTPUTSINK_HPP
+
+#include <cerrno>
+#include <cstddef>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace SimpleXlsx
+{
+
+// Receiver of the whole blocks of data prepared by XMLWriter
+class IOutputSink
+{
+    public:
+        virtual ~IOutputSink() {}
+
+        //Writes all Size bytes. Returns false on error.
+        virtual bool Write( const char * Data, size_t Size ) = 0;
+
+        //Called once after the last block
+        virtual bool Flush()
+        {
+            return true;
+        }
+
+        virtual bool IsOk() const = 0;
+};
+
+//Writes blocks to the file descriptor (a file opened by name or a descriptor given by the user)
+class FileDescriptorSink : public IOutputSink
+{
+    public:
+        inline FileDescriptorSink( const std::string & FileName ) : m_FD( -1 ), m_CloseOnDestroy( true )
+        {
+#ifdef _WIN32
+            m_FD = _open( FileName.c_str(), _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IREAD | _S_IWRITE );
+#else
+            m_FD = open( FileName.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666 );
+#endif
+        }
+
+        inline FileDescriptorSink( int FD, bool CloseOnDestroy = false ) : m_FD( FD ), m_CloseOnDestroy( CloseOnDestroy ) {}
+
+        virtual ~FileDescriptorSink()
+        {
+            if( m_CloseOnDestroy && ( m_FD >= 0 ) )
+#ifdef _WIN32
+                _close( m_FD );
+#else
+                close( m_FD );
+#endif
+        }
+
+        virtual bool Write( const char * Data, size_t Size )
+        {
+            if( m_FD < 0 )
+                return false;
+            while( Size > 0 )
+            {
+#ifdef _WIN32
+                const unsigned int Part = Size > 0x40000000 ? 0x40000000 : static_cast< unsigned int >( Size );
+                const int Written = _write( m_FD, Data, Part );
+#else
+                const ssize_t Written = write( m_FD, Data, Size );
+#endif
+                if( Written < 0 )
+                {
+                    if( errno == EINTR )
+                        continue;
+                    return false;
+                }
+                Data += Written;
+                Size -= static_cast< size_t >( Written );
+            }
+            return true;
+        }
+
+        virtual bool IsOk() const
+        {
+            return m_FD >= 0;
+        }
+
+    private:
+        //Disable copy and assignment
+        FileDescriptorSink( const FileDescriptorSink & );
+        FileDescriptorSink & operator=( const FileDescriptorSink & );
+
+        int     m_FD;
+        bool    m_CloseOnDestroy;
+};
+
+//Collects all blocks in the growable memory buffer
+class MemorySink : public IOutputSink
+{
+    public:
+        inline MemorySink( size_t ReserveSize = 0 )
+        {
+            m_Data.reserve( ReserveSize );
+        }
+
+        virtual bool Write( const char * Data, size_t Size )
+        {
+            m_Data.append( Data, Size );
+            return true;
+        }
+
+        virtual bool IsOk() const
+        {
+            return true;
+        }
+
+        // *INDENT-OFF*   For AStyle tool
+        inline const std::string & Data() const     { return m_Data; }
+        inline std::string & Data()                 { return m_Data; }
+        inline void Clear()                         { m_Data.clear(); }
+        // *INDENT-ON*   For AStyle tool
+
+    private:
+        std::string m_Data;
+};
+
+//Hands every block to the user function, e.g. to a compressor stream or a socket
+class CallbackSink : public IOutputSink
+{
+    public:
+        //Must return false on error
+        typedef bool ( * TWriteCallback )( void * UserData, const char * Data, size_t Size );
+        //Optional, called once after the last block
+        typedef bool ( * TFlushCallback )( void * UserData );
+
+        inline CallbackSink( TWriteCallback WriteCallback, void * UserData, TFlushCallback FlushCallback = NULL ) :
+            m_WriteCallback( WriteCallback ), m_FlushCallback( FlushCallback ), m_UserData( UserData ) {}
+
+        virtual bool Write( const char * Data, size_t Size )
+        {
+            return m_WriteCallback( m_UserData, Data, Size );
+        }
+
+        virtual bool Flush()
+        {
+            return ( m_FlushCallback == NULL ) || m_FlushCallback( m_UserData );
+        }
+
+        virtual bool IsOk() const
+        {
+            return m_WriteCallback != NULL;
+        }
+
+    private:
+        TWriteCallback  m_WriteCallback;
+        TFlushCallback  m_FlushCallback;
+        void      *     m_UserData;
+};
+
+}
+
+#endif // XLSX_OUTPUTSINK_HPP
@@ -29,11 +29,13 @@
 #include <stdint.h>
 
 #include "PathManager.hpp"
+#include "UTF8Encoder.hpp"
 
 #ifdef _WIN32
 #include <windows.h>
 #include <direct.h>
 #else
+#include <langinfo.h>
 #include <unistd.h>
 #include <sys/stat.h>
 #include <sys/types.h>
@@ -110,6 +112,10 @@ namespace SimpleXlsx
 #if ! defined( _WIN32 )     //Linux with Unicode
     std::string PathManager::PathEncode( const wchar_t * Path )
     {
+        const char * CodeSet = nl_langinfo( CODESET );
+        if( ( CodeSet != NULL ) && ( ( strcmp( CodeSet, "UTF-8" ) == 0 ) || ( strcmp( CodeSet, "utf8" ) == 0 ) ) )
+            return UTF8Encoder::From_wstring( Path );
+
         mbstate_t MbState;
         const wchar_t * Ptr = Path;
         //mbrlen( NULL, 0, & MbState );
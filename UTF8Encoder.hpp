@@ -24,8 +24,17 @@
 
 #include <assert.h>
 #include <stdint.h>
+#include <cwchar>
 #include <string>
 
+#if defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && ( _M_IX86_FP >= 2 ) )
+#include <emmintrin.h>
+#define SIMPLE_XLSX_UTF8_SSE2
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
 class UTF8Encoder
 {
     public:
@@ -53,13 +62,303 @@ class UTF8Encoder
             }
         }
 
-        static inline std::string From_wstring( const std::wstring & Source )
+        //Upper bound of the UTF-8 length of Len wide characters (UTF-16 units take at most 3 bytes each)
+        static inline size_t MaxLength( size_t Len )
+        {
+            return Len * ( sizeof( wchar_t ) == 2 ? 3 : 4 );
+        }
+
+        //Converts UTF-32 (or UTF-16 if wchar_t is 16-bit) to UTF-8 and returns the number of written bytes.
+        //Dest must have room for MaxLength( Len ) bytes. Surrogate pairs are joined in both encodings,
+        //lone surrogates and values above U+10FFFF are replaced with U+FFFD.
+        static inline size_t Encode( const wchar_t * Source, size_t Len, char * Dest )
+        {
+            const wchar_t * End = Source + Len;
+            char * Out = Dest;
+            while( Source < End )
+            {
+                uint32_t Code = Unit( * Source );
+                if( Code < 0x80 )
+                {
+#ifdef SIMPLE_XLSX_UTF8_SSE2
+                    const wchar_t * Next = EncodeASCIIBlocks( Source, End, Out );
+                    Out += Next - Source;
+                    Next = EncodeMixedBlocks( Next, End, Out );
+                    if( Next != Source )
+                    {
+                        Source = Next;
+                        continue;
+                    }
+#endif
+                    * Out++ = static_cast<char>( Code );
+                    Source++;
+                    continue;
+                }
+                if( Code < 0x800 )
+                {
+#ifdef SIMPLE_XLSX_UTF8_SSE2
+                    const wchar_t * Next = EncodeTwoByteBlocks( Source, End, Out );
+                    Out += ( Next - Source ) * 2;
+                    Next = EncodeMixedBlocks( Next, End, Out );
+                    if( Next != Source )
+                    {
+                        Source = Next;
+                        continue;
+                    }
+#endif
+                    Out[ 0 ] = static_cast<char>( 0xC0 | ( Code >> 6 ) );
+                    Out[ 1 ] = static_cast<char>( 0x80 | ( Code & 0x3F ) );
+                    Out += 2;
+                    Source++;
+                    continue;
+                }
+                Source++;
+                if( ( Code >= 0xD800 ) && ( Code <= 0xDFFF ) )
+                {
+                    if( ( Code <= 0xDBFF ) && ( Source < End ) && ( Unit( * Source ) >= 0xDC00 ) && ( Unit( * Source ) <= 0xDFFF ) )
+                        Code = 0x10000 + ( ( Code - 0xD800 ) << 10 ) + ( Unit( * Source++ ) - 0xDC00 );
+                    else Code = 0xFFFD;
+                }
+                else if( Code > 0x10FFFF ) Code = 0xFFFD;
+                if( Code < 0x10000 )
+                {
+                    Out[ 0 ] = static_cast<char>( 0xE0 | ( Code >> 12 ) );
+                    Out[ 1 ] = static_cast<char>( 0x80 | ( ( Code >> 6 ) & 0x3F ) );
+                    Out[ 2 ] = static_cast<char>( 0x80 | ( Code & 0x3F ) );
+                    Out += 3;
+                }
+                else
+                {
+                    Out[ 0 ] = static_cast<char>( 0xF0 | ( Code >> 18 ) );
+                    Out[ 1 ] = static_cast<char>( 0x80 | ( ( Code >> 12 ) & 0x3F ) );
+                    Out[ 2 ] = static_cast<char>( 0x80 | ( ( Code >> 6 ) & 0x3F ) );
+                    Out[ 3 ] = static_cast<char>( 0x80 | ( Code & 0x3F ) );
+                    Out += 4;
+                }
+            }
+            return static_cast<size_t>( Out - Dest );
+        }
+
+        //Appends the converted text to Dest without temporary strings
+        static inline void Append( std::string & Dest, const wchar_t * Source, size_t Len )
+        {
+            const size_t Size = Dest.size();
+            Dest.resize( Size + MaxLength( Len ) );
+            Dest.resize( Size + Encode( Source, Len, & Dest[ 0 ] + Size ) );
+        }
+
+        static inline void Assign( std::string & Dest, const std::wstring & Source )
+        {
+            Dest.clear();
+            Append( Dest, Source.data(), Source.size() );
+        }
+
+        static inline std::string From_wstring( const wchar_t * Source, size_t Len )
         {
+            char Buffer[ 1024 ];
+            if( MaxLength( Len ) <= sizeof( Buffer ) )
+                return std::string( Buffer, Encode( Source, Len, Buffer ) );
             std::string Result;
-            for( std::wstring::const_iterator iter = Source.begin(); iter != Source.end(); iter++ )
-                Result.append( From_wchar_t( * iter ) );
+            Append( Result, Source, Len );
+            if( Result.capacity() > Result.size() * 2 ) //Stored strings should not keep the reserve for the worst case
+                Result.shrink_to_fit();
             return Result;
         }
+
+        static inline std::string From_wstring( const std::wstring & Source )
+        {
+            return From_wstring( Source.data(), Source.size() );
+        }
+
+        static inline std::string From_wstring( const wchar_t * Source )
+        {
+            return From_wstring( Source, std::wcslen( Source ) );
+        }
+
+        //Decodes UTF-8 to UTF-32 (or UTF-16 with surrogate pairs if wchar_t is 16-bit).
+        //Invalid and truncated sequences are replaced with U+FFFD.
+        static inline std::wstring To_wstring( const std::string & Source )
+        {
+            std::wstring Result;
+            Result.reserve( Source.size() );
+            const unsigned char * Ptr = reinterpret_cast<const unsigned char *>( Source.data() );
+            const unsigned char * End = Ptr + Source.size();
+            while( Ptr < End )
+            {
+                const uint32_t Lead = * Ptr++;
+                if( Lead < 0x80 )
+                {
+                    Result.push_back( static_cast<wchar_t>( Lead ) );
+                    continue;
+                }
+                //Length of the sequence and the range of the second byte (Table 3-7 of the Unicode Standard)
+                size_t Tail = 0;
+                unsigned char Lo = 0x80, Hi = 0xBF;
+                if( ( Lead >= 0xC2 ) && ( Lead <= 0xDF ) ) Tail = 1;
+                else if( ( Lead >= 0xE0 ) && ( Lead <= 0xEF ) )
+                {
+                    Tail = 2;
+                    if( Lead == 0xE0 ) Lo = 0xA0;
+                    else if( Lead == 0xED ) Hi = 0x9F;
+                }
+                else if( ( Lead >= 0xF0 ) && ( Lead <= 0xF4 ) )
+                {
+                    Tail = 3;
+                    if( Lead == 0xF0 ) Lo = 0x90;
+                    else if( Lead == 0xF4 ) Hi = 0x8F;
+                }
+                uint32_t Code = Lead & ( 0x3F >> Tail );
+                size_t i = 0;
+                for( ; ( i < Tail ) && ( Ptr < End ); i++, Ptr++, Lo = 0x80, Hi = 0xBF )
+                {
+                    if( ( * Ptr < Lo ) || ( * Ptr > Hi ) )
+                        break;
+                    Code = ( Code << 6 ) | ( * Ptr & 0x3F );
+                }
+                if( ( Tail == 0 ) || ( i < Tail ) )     //The bad byte starts the next sequence
+                    Code = 0xFFFD;
+                if( ( sizeof( wchar_t ) == 2 ) && ( Code >= 0x10000 ) )
+                {
+                    Result.push_back( static_cast<wchar_t>( 0xD800 + ( ( Code - 0x10000 ) >> 10 ) ) );
+                    Result.push_back( static_cast<wchar_t>( 0xDC00 + ( ( Code - 0x10000 ) & 0x3FF ) ) );
+                }
+                else Result.push_back( static_cast<wchar_t>( Code ) );
+            }
+            return Result;
+        }
+
+    private:
+        static inline uint32_t Unit( wchar_t Ch )
+        {
+            return ( sizeof( wchar_t ) == 2 ) ? static_cast<uint16_t>( Ch ) : static_cast<uint32_t>( Ch );
+        }
+
+#ifdef SIMPLE_XLSX_UTF8_SSE2
+        //Copies blocks of 16 ASCII characters, returns the first not copied character.
+        //The block with other characters is copied up to the first of them, so mixed text is not probed character by character.
+        //Out must have room for 16 bytes more than are copied.
+        static inline const wchar_t * EncodeASCIIBlocks( const wchar_t * Source, const wchar_t * End, char * Out )
+        {
+            const __m128i Zero = _mm_setzero_si128();
+            for( ; End - Source >= 16; Source += 16, Out += 16 )
+            {
+                __m128i Packed;
+                int Mask;   //Bit per character, set for ASCII
+                if( sizeof( wchar_t ) == 2 )
+                {
+                    const __m128i NotASCII = _mm_set1_epi16( ~0x7F );
+                    const __m128i A = Load( Source ), B = Load( Source + 8 );
+                    Packed = _mm_packus_epi16( A, B );
+                    Mask = _mm_movemask_epi8( _mm_packs_epi16( _mm_cmpeq_epi16( _mm_and_si128( A, NotASCII ), Zero ),
+                                                               _mm_cmpeq_epi16( _mm_and_si128( B, NotASCII ), Zero ) ) );
+                }
+                else
+                {
+                    const __m128i NotASCII = _mm_set1_epi32( ~0x7F );
+                    const __m128i A = Load( Source ), B = Load( Source + 4 ), C = Load( Source + 8 ), D = Load( Source + 12 );
+                    Packed = _mm_packus_epi16( _mm_packs_epi32( A, B ), _mm_packs_epi32( C, D ) );
+                    Mask = _mm_movemask_epi8( _mm_packs_epi16(
+                                                  _mm_packs_epi32( _mm_cmpeq_epi32( _mm_and_si128( A, NotASCII ), Zero ), _mm_cmpeq_epi32( _mm_and_si128( B, NotASCII ), Zero ) ),
+                                                  _mm_packs_epi32( _mm_cmpeq_epi32( _mm_and_si128( C, NotASCII ), Zero ), _mm_cmpeq_epi32( _mm_and_si128( D, NotASCII ), Zero ) ) ) );
+                }
+                _mm_storeu_si128( reinterpret_cast<__m128i *>( Out ), Packed );
+                if( Mask != 0xFFFF )
+                    return Source + FirstBit( ~Mask );
+            }
+            return Source;
+        }
+
+        //Converts blocks of 8 characters from U+0080 to U+07FF (Latin supplements, Greek, Cyrillic, Hebrew, Arabic)
+        //into 16 bytes, returns the first not converted character.
+        //The block with other characters is converted up to the first of them. Out must have room for 16 bytes more.
+        static inline const wchar_t * EncodeTwoByteBlocks( const wchar_t * Source, const wchar_t * End, char * Out )
+        {
+            for( ; End - Source >= 8; Source += 8, Out += 16 )
+            {
+                __m128i Codes;
+                int Mask;   //Two bits per character, set for the characters in the range
+                if( sizeof( wchar_t ) == 2 )
+                {
+                    Codes = Load( Source );
+                    Mask = _mm_movemask_epi8( _mm_and_si128( _mm_cmpgt_epi16( Codes, _mm_set1_epi16( 0x7F ) ),
+                                                             _mm_cmplt_epi16( Codes, _mm_set1_epi16( 0x800 ) ) ) );
+                }
+                else
+                {
+                    const __m128i A = Load( Source ), B = Load( Source + 4 );
+                    const __m128i Low = _mm_set1_epi32( 0x7F ), High = _mm_set1_epi32( 0x800 );
+                    Mask = _mm_movemask_epi8( _mm_packs_epi32( _mm_and_si128( _mm_cmpgt_epi32( A, Low ), _mm_cmplt_epi32( A, High ) ),
+                                                               _mm_and_si128( _mm_cmpgt_epi32( B, Low ), _mm_cmplt_epi32( B, High ) ) ) );
+                    Codes = _mm_packs_epi32( A, B );  //Saturated lanes are not in the range and are not used
+                }
+                //Every 16-bit lane becomes the pair 110xxxxx 10xxxxxx in the memory order
+                const __m128i Lead = _mm_or_si128( _mm_srli_epi16( Codes, 6 ), _mm_set1_epi16( 0xC0 ) );
+                const __m128i Cont = _mm_or_si128( _mm_and_si128( Codes, _mm_set1_epi16( 0x3F ) ), _mm_set1_epi16( 0x80 ) );
+                _mm_storeu_si128( reinterpret_cast<__m128i *>( Out ), _mm_or_si128( Lead, _mm_slli_epi16( Cont, 8 ) ) );
+                if( Mask != 0xFFFF )
+                    return Source + FirstBit( ~Mask ) / 2;
+            }
+            return Source;
+        }
+
+        //Converts blocks of 8 characters below U+0800 that mix ASCII with two-byte characters (words and spaces,
+        //digits, punctuation) without branches per character, moves Out and returns the first not converted character.
+        //The block with other characters is converted up to the first of them. Pure blocks are left to the functions above.
+        static inline const wchar_t * EncodeMixedBlocks( const wchar_t * Source, const wchar_t * End, char *& Out )
+        {
+            const __m128i Zero = _mm_setzero_si128();
+            while( End - Source >= 8 )
+            {
+                int Small, ASCII;   //Bit pairs per character, set for the characters below U+0800 and below U+0080
+                if( sizeof( wchar_t ) == 2 )
+                {
+                    const __m128i Codes = Load( Source );
+                    Small = _mm_movemask_epi8( _mm_cmpeq_epi16( _mm_and_si128( Codes, _mm_set1_epi16( ~0x7FF ) ), Zero ) );
+                    ASCII = _mm_movemask_epi8( _mm_cmpeq_epi16( _mm_and_si128( Codes, _mm_set1_epi16( ~0x7F ) ), Zero ) );
+                }
+                else
+                {
+                    const __m128i A = Load( Source ), B = Load( Source + 4 );
+                    const __m128i NotSmall = _mm_set1_epi32( ~0x7FF ), NotASCII = _mm_set1_epi32( ~0x7F );
+                    Small = _mm_movemask_epi8( _mm_packs_epi32( _mm_cmpeq_epi32( _mm_and_si128( A, NotSmall ), Zero ),
+                                                                _mm_cmpeq_epi32( _mm_and_si128( B, NotSmall ), Zero ) ) );
+                    ASCII = _mm_movemask_epi8( _mm_packs_epi32( _mm_cmpeq_epi32( _mm_and_si128( A, NotASCII ), Zero ),
+                                                                _mm_cmpeq_epi32( _mm_and_si128( B, NotASCII ), Zero ) ) );
+                }
+                if( ( ASCII == 0xFFFF ) || ( ( ASCII == 0 ) && ( Small == 0xFFFF ) ) )
+                    break;
+                const size_t Count = ( Small == 0xFFFF ) ? 8 : FirstBit( ~Small ) / 2;
+                for( size_t i = 0; i < Count; i++ )
+                {
+                    const uint32_t Code = Unit( Source[ i ] );
+                    const size_t Two = Code >= 0x80 ? 1 : 0;
+                    Out[ 0 ] = static_cast<char>( Two != 0 ? 0xC0 | ( Code >> 6 ) : Code );
+                    Out[ 1 ] = static_cast<char>( 0x80 | ( Code & 0x3F ) );
+                    Out += 1 + Two;
+                }
+                Source += Count;
+                if( Count < 8 )
+                    break;
+            }
+            return Source;
+        }
+
+        static inline size_t FirstBit( int Mask )
+        {
+#ifdef _MSC_VER
+            unsigned long Index;
+            _BitScanForward( & Index, static_cast<unsigned long>( Mask ) );
+            return Index;
+#else
+            return static_cast<size_t>( __builtin_ctz( static_cast<unsigned int>( Mask ) ) );
+#endif
+        }
+
+        static inline __m128i Load( const wchar_t * Source )
+        {
+            return _mm_loadu_si128( reinterpret_cast<const __m128i *>( Source ) );
+        }
+#endif
 };
 
 
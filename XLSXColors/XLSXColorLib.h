@@ -33,6 +33,7 @@ namespace SimpleXlsx
      virtual ~XLSXColorLib();
      void AddColor(const char * id, const clsRGBColorRecord & cl){ lib[id]=cl;  };
      const char * GetColor(const char * id) { return lib.at(id).Get(); };
+     Color GetPackedColor(const char * id) { return lib.at(id).GetColor(); };
      void Clear() { lib.clear(); };
    };
  extern void make_grayscale10(XLSXColorLib & xlib);
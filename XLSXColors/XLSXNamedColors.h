@@ -0,0 +1,142 @@
+/*
+  SimpleXlsxWriter
+  Copyright (C) 2012-2021 Pavel Akimov <oxod.pavel@gmail.com>, Alexandr Belyak <programmeralex@bk.ru>
+
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef XLSX_NAMEDCOLORS_H
+#define XLSX_NAMEDCOLORS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "../Xlsx/SimpleXlsxDef.h"
+
+namespace SimpleXlsx
+{
+// ****************************************************************************
+/// @brief	Compile-time table of the named colors of XLSXColorLib (make_excell_like_named_colors
+///         and make_grayscale10), e.g. constexpr Color Header = NamedColors::Find( "Light Blue" );
+/// @note	Names are found by the perfect hash: FNV-1a with Seed, the top SlotBits bits give the slot.
+///         After changes of the table Seed must be chosen again so that the names get distinct slots.
+// ****************************************************************************
+namespace NamedColors
+{
+struct Entry
+{
+    const char *    Name;
+    uint32_t        ARGB;
+};
+
+constexpr Entry Table[] =
+{
+            { "Black",             0xFF000000 },
+            { "Gray10%",           0xFF191919 },
+            { "Gray20%",           0xFF333333 },
+            { "Gray30%",           0xFF4C4C4C },
+            { "Gray40%",           0xFF666666 },
+            { "Gray50%",           0xFF7F7F7F },
+            { "Gray60%",           0xFF999999 },
+            { "Gray70%",           0xFFB2B2B2 },
+            { "Gray80%",           0xFFCCCCCC },
+            { "Gray90%",           0xFFE5E5E5 },
+            { "White",             0xFFFFFFFF },
+            { "Brown",             0xFF993300 },
+            { "Olive Green",       0xFF333300 },
+            { "Dark Green",        0xFF003300 },
+            { "Dark Teal",         0xFF003366 },
+            { "Dark Blue",         0xFF000080 },
+            { "Indigo",            0xFF333399 },
+            { "Dark Red",          0xFF800000 },
+            { "Orange",            0xFFFF6600 },
+            { "Dark Yellow",       0xFF808000 },
+            { "Green",             0xFF008000 },
+            { "Teal",              0xFF008080 },
+            { "Blue",              0xFF0000FF },
+            { "Blue-Gray",         0xFF666699 },
+            { "Red",               0xFFFF0000 },
+            { "Light Orange",      0xFFFF9900 },
+            { "Lime",              0xFF99CC00 },
+            { "Sea Green",         0xFF339966 },
+            { "Aqua",              0xFF33CCCC },
+            { "Light Blue",        0xFF3366FF },
+            { "Violet",            0xFF800080 },
+            { "Pink",              0xFFFF00FF },
+            { "Gold",              0xFFFFCC00 },
+            { "Yellow",            0xFFFFFF00 },
+            { "Bright Green",      0xFF00FF00 },
+            { "Turquoise",         0xFF00FFFF },
+            { "Sky Blue",          0xFF00CCFF },
+            { "Plum",              0xFF993366 },
+            { "Rose",              0xFFFF99CC },
+            { "Tan",               0xFFFFCC99 },
+            { "Light Yellow",      0xFFFFFF99 },
+            { "Light Green",       0xFFCCFFCC },
+            { "Light Turquoise",   0xFFCCFFFF },
+            { "Pale Blue",         0xFF99CCFF },
+            { "Lavender",          0xFFCC99FF },
+            { "Periwinkle",        0xFF9999FF },
+            { "Dark Purple",       0xFF660066 },
+            { "Coral",             0xFFFF8080 },
+            { "Ocean Blue",        0xFF0066CC },
+            { "Ice Blue",          0xFFCCCCFF },
+            { "Gray",              0xFF7F7F7F },
+};
+
+constexpr size_t Count = sizeof( Table ) / sizeof( Table[ 0 ] );
+
+constexpr uint32_t Seed = 46177;
+constexpr unsigned SlotBits = 7;
+constexpr uint8_t NoEntry = 0xFF;
+
+// Index in Table for every value of the hash
+constexpr uint8_t Slots[ 1 << SlotBits ] =
+{
+              6,  37, 255, 255, 255, 255, 255,  36, 255, 255,  16, 255, 255, 255, 255,  21,
+             15,   0, 255, 255,  18,  28,  22,  39,  19, 255, 255,   2,  49, 255, 255,   7,
+            255,  47, 255,  41, 255,  24,  29, 255,  12, 255, 255,  32, 255, 255, 255, 255,
+            255, 255, 255, 255,  27,  20,  14, 255,   1,   3, 255, 255,   9, 255, 255,  48,
+             43, 255,  11, 255, 255, 255, 255,  42, 255, 255, 255,  44, 255, 255, 255, 255,
+            255, 255, 255, 255,  45,  35,  46, 255, 255, 255, 255, 255,  26, 255,   5, 255,
+              4,  13, 255,  23, 255,  25, 255, 255, 255,  17,  33, 255,  38, 255,  40,  31,
+            255, 255, 255, 255, 255, 255, 255,  10,  30,  34,  50, 255, 255, 255,   8, 255,
+};
+
+// *INDENT-OFF*   For AStyle tool
+constexpr uint32_t Hash( const char * Name, uint32_t Value = Seed )
+{ return ( * Name == '\0' ) ? Value : Hash( Name + 1, ( Value ^ static_cast<uint8_t>( * Name ) ) * 16777619u ); }
+
+constexpr bool Equal( const char * A, const char * B )
+{ return ( * A == * B ) && ( ( * A == '\0' ) || Equal( A + 1, B + 1 ) ); }
+
+constexpr uint8_t Slot( const char * Name )     { return Slots[ Hash( Name ) >> ( 32 - SlotBits ) ]; }
+
+// Returns the color with the Name (case-sensitive), the color is not set if the name is unknown
+constexpr Color Find( const char * Name )
+{ return ( ( Slot( Name ) != NoEntry ) && Equal( Table[ Slot( Name ) ].Name, Name ) ) ? Color( Table[ Slot( Name ) ].ARGB ) : Color(); }
+
+constexpr bool IsPerfect( size_t Index = 0 )
+{ return ( Index == Count ) || ( ( Slot( Table[ Index ].Name ) == Index ) && IsPerfect( Index + 1 ) ); }
+// *INDENT-ON*   For AStyle tool
+
+static_assert( IsPerfect(), "Every name must have its own slot" );
+}
+
+}
+
+#endif // XLSX_NAMEDCOLORS_H
@@ -22,6 +22,7 @@
 #ifndef CLSRGBCOLORRECORD_H
 #define CLSRGBCOLORRECORD_H
 #include <string>
+#include "../Xlsx/SimpleXlsxDef.h"
 namespace SimpleXlsx
 {
 class clsRGBColorRecord
@@ -36,6 +37,7 @@ class clsRGBColorRecord
         clsRGBColorRecord(const clsRGBColorRecord& other);
         clsRGBColorRecord& operator=(const clsRGBColorRecord& other);
         const char * Get() const {return colstr;};
+        Color GetColor() const {return Color(colstr);};
         void Set(const unsigned char r, const unsigned char g, const unsigned char b);
         void Set(const unsigned char chargs);
         void Set(const double gs);
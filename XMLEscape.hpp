@@ -0,0 +1,190 @@
+/*
+  SimpleXlsxWriter
+  Copyright (C) 2012-2021 Pavel Akimov <oxod.pavel@gmail.com>, Alexandr Belyak <programmeralex@bk.ru>
+
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef XLSX_XMLESCAPE_HPP
+#define XLSX_XMLESCAPE_HPP
+
+#include <cstddef>
+
+#include <stdint.h>
+
+#if defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && ( _M_IX86_FP >= 2 ) )
+#include <emmintrin.h>
+#define SIMPLE_XLSX_USE_SSE2
+#endif
+
+#if defined( __AVX2__ )
+#include <immintrin.h>
+#define SIMPLE_XLSX_USE_AVX2
+#endif
+
+#if defined( _MSC_VER ) && ( defined( SIMPLE_XLSX_USE_SSE2 ) || defined( SIMPLE_XLSX_USE_AVX2 ) )
+#include <intrin.h>
+#endif
+
+namespace SimpleXlsx
+{
+
+//Helpers for writing the text content of XML 1.0 documents
+class XMLEscape
+{
+    public:
+        //Returns the first character in [Str, End) that can not be copied as is:
+        //  & < > ' " , control characters (including tab, CR and LF), bytes of non-ASCII characters
+        //  and, if Underscore is true, '_' (start of possible _xHHHH_ sequence).
+        //Returns End if there are no such characters.
+        static inline const char * FindSpecial( const char * Str, const char * End, bool Underscore )
+        {
+#ifdef SIMPLE_XLSX_USE_AVX2
+            {
+                const __m256i Amp = _mm256_set1_epi8( '&' ), Lt = _mm256_set1_epi8( '<' ), Gt = _mm256_set1_epi8( '>' );
+                const __m256i Apos = _mm256_set1_epi8( '\'' ), Quot = _mm256_set1_epi8( '"' );
+                const __m256i Under = _mm256_set1_epi8( Underscore ? '_' : '&' );
+                const __m256i Space = _mm256_set1_epi8( 0x20 );
+                for( ; End - Str >= 32; Str += 32 )
+                {
+                    const __m256i Val = _mm256_loadu_si256( reinterpret_cast< const __m256i * >( Str ) );
+                    __m256i Res = _mm256_or_si256( _mm256_cmpeq_epi8( Val, Amp ), _mm256_cmpeq_epi8( Val, Lt ) );
+                    Res = _mm256_or_si256( Res, _mm256_or_si256( _mm256_cmpeq_epi8( Val, Gt ), _mm256_cmpeq_epi8( Val, Apos ) ) );
+                    Res = _mm256_or_si256( Res, _mm256_or_si256( _mm256_cmpeq_epi8( Val, Quot ), _mm256_cmpeq_epi8( Val, Under ) ) );
+                    Res = _mm256_or_si256( Res, _mm256_cmpgt_epi8( Space, Val ) );  //Signed: control and non-ASCII bytes
+                    const uint32_t Mask = static_cast< uint32_t >( _mm256_movemask_epi8( Res ) );
+                    if( Mask != 0 )
+                        return Str + FirstBit( Mask );
+                }
+            }
+#endif
+#ifdef SIMPLE_XLSX_USE_SSE2
+            {
+                const __m128i Amp = _mm_set1_epi8( '&' ), Lt = _mm_set1_epi8( '<' ), Gt = _mm_set1_epi8( '>' );
+                const __m128i Apos = _mm_set1_epi8( '\'' ), Quot = _mm_set1_epi8( '"' );
+                const __m128i Under = _mm_set1_epi8( Underscore ? '_' : '&' );
+                const __m128i Space = _mm_set1_epi8( 0x20 );
+                for( ; End - Str >= 16; Str += 16 )
+                {
+                    const __m128i Val = _mm_loadu_si128( reinterpret_cast< const __m128i * >( Str ) );
+                    __m128i Res = _mm_or_si128( _mm_cmpeq_epi8( Val, Amp ), _mm_cmpeq_epi8( Val, Lt ) );
+                    Res = _mm_or_si128( Res, _mm_or_si128( _mm_cmpeq_epi8( Val, Gt ), _mm_cmpeq_epi8( Val, Apos ) ) );
+                    Res = _mm_or_si128( Res, _mm_or_si128( _mm_cmpeq_epi8( Val, Quot ), _mm_cmpeq_epi8( Val, Under ) ) );
+                    Res = _mm_or_si128( Res, _mm_cmplt_epi8( Val, Space ) );    //Signed: control and non-ASCII bytes
+                    const uint32_t Mask = static_cast< uint32_t >( _mm_movemask_epi8( Res ) );
+                    if( Mask != 0 )
+                        return Str + FirstBit( Mask );
+                }
+            }
+#endif
+            for( ; Str < End; Str++ )
+            {
+                const unsigned char Ch = static_cast< unsigned char >( * Str );
+                if( ( Ch < 0x20 ) || ( Ch >= 0x80 ) || ( Ch == '&' ) || ( Ch == '<' ) || ( Ch == '>' ) ||
+                        ( Ch == '\'' ) || ( Ch == '"' ) || ( Underscore && ( Ch == '_' ) ) )
+                    break;
+            }
+            return Str;
+        }
+
+        //Checks the UTF-8 sequence started with non-ASCII byte Str[ 0 ] (see Table 3-7 of the Unicode Standard).
+        //Returns the length of the sequence and its code point, or 0 for invalid or truncated sequence.
+        static inline size_t UTF8Sequence( const char * Str, const char * End, uint32_t & CodePoint )
+        {
+            const unsigned char * S = reinterpret_cast< const unsigned char * >( Str );
+            const size_t Avail = static_cast< size_t >( End - Str );
+            const unsigned char Lead = S[ 0 ];
+            if( Lead < 0xC2 )
+                return 0;
+            if( Lead < 0xE0 )
+            {
+                if( ( Avail < 2 ) || ! IsCont( S[ 1 ], 0x80, 0xBF ) )
+                    return 0;
+                CodePoint = ( uint32_t( Lead & 0x1F ) << 6 ) | ( S[ 1 ] & 0x3F );
+                return 2;
+            }
+            if( Lead < 0xF0 )
+            {
+                const unsigned char Lo = ( Lead == 0xE0 ) ? 0xA0 : 0x80, Hi = ( Lead == 0xED ) ? 0x9F : 0xBF;
+                if( ( Avail < 3 ) || ! IsCont( S[ 1 ], Lo, Hi ) || ! IsCont( S[ 2 ], 0x80, 0xBF ) )
+                    return 0;
+                CodePoint = ( uint32_t( Lead & 0x0F ) << 12 ) | ( uint32_t( S[ 1 ] & 0x3F ) << 6 ) | ( S[ 2 ] & 0x3F );
+                return 3;
+            }
+            if( Lead < 0xF5 )
+            {
+                const unsigned char Lo = ( Lead == 0xF0 ) ? 0x90 : 0x80, Hi = ( Lead == 0xF4 ) ? 0x8F : 0xBF;
+                if( ( Avail < 4 ) || ! IsCont( S[ 1 ], Lo, Hi ) || ! IsCont( S[ 2 ], 0x80, 0xBF ) || ! IsCont( S[ 3 ], 0x80, 0xBF ) )
+                    return 0;
+                CodePoint = ( uint32_t( Lead & 0x07 ) << 18 ) | ( uint32_t( S[ 1 ] & 0x3F ) << 12 ) |
+                            ( uint32_t( S[ 2 ] & 0x3F ) << 6 ) | ( S[ 3 ] & 0x3F );
+                return 4;
+            }
+            return 0;
+        }
+
+        //Checks for _xHHHH_ at Str, which is decoded by spreadsheet applications as the character with code HHHH
+        static inline bool IsHexEscape( const char * Str, const char * End )
+        {
+            if( ( End - Str < 7 ) || ( Str[ 0 ] != '_' ) || ( ( Str[ 1 ] != 'x' ) && ( Str[ 1 ] != 'X' ) ) || ( Str[ 6 ] != '_' ) )
+                return false;
+            for( int i = 2; i < 6; i++ )
+                if( ! IsHexDigit( Str[ i ] ) )
+                    return false;
+            return true;
+        }
+
+        //Writes _xHHHH_ for the character code and returns 7
+        static inline size_t HexEscape( uint32_t Code, char * Buffer )
+        {
+            const char * Hex = "0123456789ABCDEF";
+            Buffer[ 0 ] = '_';
+            Buffer[ 1 ] = 'x';
+            for( int i = 5; i >= 2; i--, Code >>= 4 )
+                Buffer[ i ] = Hex[ Code & 0x0F ];
+            Buffer[ 6 ] = '_';
+            return 7;
+        }
+
+    private:
+        static inline bool IsCont( unsigned char Ch, unsigned char Lo, unsigned char Hi )
+        {
+            return ( Ch >= Lo ) && ( Ch <= Hi );
+        }
+
+        static inline bool IsHexDigit( char Ch )
+        {
+            return ( ( Ch >= '0' ) && ( Ch <= '9' ) ) || ( ( Ch >= 'A' ) && ( Ch <= 'F' ) ) || ( ( Ch >= 'a' ) && ( Ch <= 'f' ) );
+        }
+
+#if defined( SIMPLE_XLSX_USE_SSE2 ) || defined( SIMPLE_XLSX_USE_AVX2 )
+        static inline size_t FirstBit( uint32_t Mask )
+        {
+#ifdef _MSC_VER
+            unsigned long Index;
+            _BitScanForward( & Index, Mask );
+            return Index;
+#else
+            return static_cast< size_t >( __builtin_ctz( Mask ) );
+#endif
+        }
+#endif
+};
+
+}
+
+#endif // XLSX_XMLESCAPE_HPP
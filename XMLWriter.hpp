@@ -23,11 +23,18 @@
 #define XMLWRITER_H
 
 #include <cassert>
+#include <cstring>
 #include <limits>
 #include <iostream>
-#include <fstream>
-#include <stack>
+#include <sstream>
 #include <string>
+#include <vector>
+
+#include <stdint.h>
+
+#include "NumberToChars.hpp"
+#include "XMLEscape.hpp"
+#include "OutputSink.hpp"
 
 namespace SimpleXlsx
 {
@@ -35,43 +42,128 @@ namespace SimpleXlsx
 class XMLWriter
 {
     public:
-        inline XMLWriter( const std::string & FileName ) : m_TagOpen( false ), m_SelfClosed( true )
+        static const size_t DefaultBufferSize = 256 * 1024;
+
+        //Handling of the characters that XML 1.0 does not allow (control characters, U+FFFE and U+FFFF)
+        enum EControlChars
+        {
+            CONTROL_CHARS_STRIP = 0,    ///< the characters are dropped
+            CONTROL_CHARS_ENCODE        ///< the characters are written as _xHHHH_ (for cell texts), literal _xHHHH_ is written as _x005F_xHHHH_
+        };
+
+        inline XMLWriter( const std::string & FileName, size_t BufferSize = DefaultBufferSize ) :
+            m_TagOpen( false ), m_SelfClosed( true ), m_Sink( new FileDescriptorSink( FileName ) ), m_OwnSink( true )
         {
-            Init( FileName );
+            assert( ! FileName.empty() );
+            Init( BufferSize );
+        }
+
+        //The Sink must stay alive until the writer is destroyed
+        inline XMLWriter( IOutputSink & Sink, size_t BufferSize = DefaultBufferSize ) :
+            m_TagOpen( false ), m_SelfClosed( true ), m_Sink( & Sink ), m_OwnSink( false )
+        {
+            Init( BufferSize );
         }
 
         inline ~XMLWriter()
         {
             EndAll();
             DebugCheckIsLightTagOpened();
+            Flush();
+            if( m_OwnSink )
+                delete m_Sink;
         }
 
         inline bool IsOk() const
         {
-            return m_OStream.is_open();
+            return m_Ok && m_Sink->IsOk();
         }
 
-        //Returns the current precision of floating point
+        //Returns the current precision of floating point.
+        //Zero means the shortest representation that is read back to the same value.
         std::streamsize GetFloatPrecision()
         {
-            return m_OStream.precision();
+            return m_FloatPrecision;
         }
 
-        //Set the current precision for floating point.
+        //Set the current precision (significant digits) for floating point, zero for the shortest representation.
+        //The precision is limited to NumberToChars::MaxPrecision, more digits do not change the value read back.
         //Returns the precision before the call this function.
         std::streamsize SetFloatPrecision( std::streamsize NewPrecision )
         {
-            return m_OStream.precision( NewPrecision );
+            const std::streamsize Result = m_FloatPrecision;
+            if( NewPrecision < 0 )
+                NewPrecision = 0;
+            if( NewPrecision > NumberToChars::MaxPrecision )
+                NewPrecision = NumberToChars::MaxPrecision;
+            m_FloatPrecision = static_cast< int >( NewPrecision );
+            return Result;
+        }
+
+        inline EControlChars GetControlChars() const
+        {
+            return m_ControlChars;
+        }
+
+        //Returns the mode before the call this function.
+        inline EControlChars SetControlChars( EControlChars Mode )
+        {
+            const EControlChars Result = m_ControlChars;
+            m_ControlChars = Mode;
+            return Result;
         }
 
         std::streamoff GetCurrentPosition()
         {
-            return m_OStream.tellp();
+            return static_cast< std::streamoff >( m_Flushed + m_BufPos );
+        }
+
+        //Hands all buffered data to the sink
+        inline bool Flush()
+        {
+            FlushBuffer();
+            if( ! m_Sink->Flush() )
+                m_Ok = false;
+            return m_Ok;
         }
 
         inline XMLWriter & Raw( const char * Str, size_t Len )
         {
-            m_OStream.write( Str, Len );
+            Write( Str, Len );
+            return * this;
+        }
+
+        //Fragment API: pre-rendered pieces of markup are written as is, without any checks of the structure.
+        //Fragment() closes the opened tag, the fragments are its content. For example:
+        //  Fragment().Lit( "<c r=\"" ).Raw( Ref, RefLen ).Lit( "\"><v>" ).Value( 1.5 ).Lit( "</v></c>" )
+        inline XMLWriter & Fragment()
+        {
+            CloseOpenedTag();
+            DebugCheckIsLightTagOpened();
+            m_SelfClosed = false;
+            return * this;
+        }
+
+        //Writes the string literal, its length is known at compile time
+        template< size_t N >
+        inline XMLWriter & Lit( const char ( & Literal )[ N ] )
+        {
+            Write( Literal, N - 1 );
+            return * this;
+        }
+
+        //Writes the text with escaping (see SetControlChars)
+        inline XMLWriter & Text( const char * Str, size_t Len )
+        {
+            WriteStringEscape( Str, Len );
+            return * this;
+        }
+
+        //Writes the number or the text without escaping
+        template< typename _T >
+        inline XMLWriter & Value( _T Val )
+        {
+            WriteValue( Val );
             return * this;
         }
 
@@ -83,7 +175,8 @@ class XMLWriter
             assert( TagName != NULL );
             DebugCheckAndIncLightTag();
             CloseOpenedTag();
-            m_OStream << '<' << TagName;
+            Put( '<' );
+            WriteStr( TagName );
             m_TagOpen = true;
             m_SelfClosed = false;
             return * this;
@@ -95,20 +188,22 @@ class XMLWriter
         inline XMLWriter & EndL()
         {
             DebugCheckAndDecLightTag();
-            m_OStream << "/>";
+            Write( "/>", 2 );
             m_TagOpen = false;
             return * this;
         }
 
+        //TagName is not copied and must stay valid until End (string literals are expected)
         inline XMLWriter & Tag( const char * TagName )
         {
             assert( TagName != NULL );
             CloseOpenedTag();
             DebugCheckIsLightTagOpened();
-            m_OStream << '<' << TagName;
+            Put( '<' );
+            WriteStr( TagName );
             m_TagOpen = true;
             m_SelfClosed = true;
-            m_Tags.push( TagName );
+            m_Tags.push_back( TagName );
             return * this;
         }
 
@@ -117,19 +212,24 @@ class XMLWriter
             assert( ! m_Tags.empty() );
             DebugCheckIsLightTagOpened();
             if( m_SelfClosed )
-                m_OStream << "/>";
-            else m_OStream << "</" << m_Tags.top() << '>';
+                Write( "/>", 2 );
+            else
+            {
+                Write( "</", 2 );
+                WriteStr( m_Tags.back() );
+                Put( '>' );
+            }
 #ifndef NDEBUG
             if( TagName != NULL )
             {
-                if( m_Tags.top() != TagName )
-                    std::cerr << "Wrong TagName for End: " << TagName << ". Wanted: " << m_Tags.top() << std::endl;
-                assert( m_Tags.top() == TagName );
+                if( std::strcmp( m_Tags.back(), TagName ) != 0 )
+                    std::cerr << "Wrong TagName for End: " << TagName << ". Wanted: " << m_Tags.back() << std::endl;
+                assert( std::strcmp( m_Tags.back(), TagName ) == 0 );
             }
 #else
             ( void )TagName;
 #endif
-            m_Tags.pop();
+            m_Tags.pop_back();
             m_TagOpen = false;
             m_SelfClosed = false;
             return * this;
@@ -144,19 +244,18 @@ class XMLWriter
 
         inline XMLWriter & TagOnlyContent( const char * TagName, const char * ContentString )
         {
-            assert( TagName != NULL );
-            CloseOpenedTag();
-            DebugCheckIsLightTagOpened();
-            m_OStream << '<' << TagName << '>';
-            WriteStringEscape( ContentString );
-            m_OStream << "</" << TagName << '>';
-            m_SelfClosed = false;
-            return * this;
+            return TagOnlyContentInt( TagName, ContentString, std::strlen( ContentString ) );
         }
 
         inline XMLWriter & TagOnlyContent( const char * TagName, const std::string  & ContentString )
         {
-            return TagOnlyContent( TagName, ContentString.c_str() );
+            return TagOnlyContentInt( TagName, ContentString.c_str(), ContentString.size() );
+        }
+
+        //The content string with the known length (may be not null-terminated)
+        inline XMLWriter & TagOnlyContent( const char * TagName, const char * ContentString, size_t Len )
+        {
+            return TagOnlyContentInt( TagName, ContentString, Len );
         }
 
         //TagOnlyContent() template for all streamable types
@@ -165,7 +264,13 @@ class XMLWriter
         {
             CloseOpenedTag();
             DebugCheckIsLightTagOpened();
-            m_OStream << '<' << TagName << '>' << Value << "</" << TagName << '>';
+            Put( '<' );
+            WriteStr( TagName );
+            Put( '>' );
+            WriteValue( Value );
+            Write( "</", 2 );
+            WriteStr( TagName );
+            Put( '>' );
             m_SelfClosed = false;
             return *this;
         }
@@ -178,7 +283,24 @@ class XMLWriter
         {
             assert( AttrName != NULL );
             assert( m_TagOpen );
-            m_OStream << ' ' << AttrName << "=\"" << String << '"';
+            Put( ' ' );
+            WriteStr( AttrName );
+            Write( "=\"", 2 );
+            WriteStr( String );
+            Put( '"' );
+            return * this;
+        }
+
+        //Fast writing an attribute with the known length of the value (no escaping)
+        inline XMLWriter & Attr( const char * AttrName, const char * String, size_t Len )
+        {
+            assert( AttrName != NULL );
+            assert( m_TagOpen );
+            Put( ' ' );
+            WriteStr( AttrName );
+            Write( "=\"", 2 );
+            Write( String, Len );
+            Put( '"' );
             return * this;
         }
 
@@ -191,7 +313,7 @@ class XMLWriter
         //Attr() overload for std::string type
         inline XMLWriter & Attr( const char * AttrName, const std::string & String )
         {
-            return AttrInt( AttrName, String.c_str() );
+            return AttrInt( AttrName, String.c_str(), String.size() );
         }
 
         //Attr() function template for all streamable types
@@ -200,9 +322,11 @@ class XMLWriter
         {
             assert( AttrName != NULL );
             assert( m_TagOpen );
-            m_OStream.put( ' ' );
-            m_OStream << AttrName << "=\"" << Value;
-            m_OStream.put( '"' );
+            Put( ' ' );
+            WriteStr( AttrName );
+            Write( "=\"", 2 );
+            WriteValue( Value );
+            Put( '"' );
             return *this;
         }
 
@@ -212,11 +336,7 @@ class XMLWriter
         //Write an content for the current Tag
         inline XMLWriter & Cont( const char * String )
         {
-            CloseOpenedTag();
-            DebugCheckIsLightTagOpened();
-            WriteStringEscape( String );
-            m_SelfClosed = false;
-            return * this;
+            return ContInt( String, std::strlen( String ) );
         }
 
         //Write an content for the current Tag
@@ -228,7 +348,7 @@ class XMLWriter
         //Content() overload for std::string type
         inline XMLWriter & Cont( const std::string & String )
         {
-            return Cont( String.c_str() );
+            return ContInt( String.c_str(), String.size() );
         }
 
         //Content() template for all streamable types
@@ -237,7 +357,7 @@ class XMLWriter
         {
             CloseOpenedTag();
             DebugCheckIsLightTagOpened();
-            m_OStream << Value;
+            WriteValue( Value );
             m_SelfClosed = false;
             return *this;
         }
@@ -247,54 +367,258 @@ class XMLWriter
 
     private:
         bool                    m_TagOpen, m_SelfClosed;
-        std::ofstream           m_OStream;
-        std::stack<std::string> m_Tags;
-
-        inline void Init( const std::string & FileName )
+        std::vector< const char * > m_Tags;         ///< names of the opened tags, not copied
+
+        IOutputSink      *      m_Sink;             ///< receiver of the filled blocks
+        bool                    m_OwnSink;          ///< the sink has been created by the writer
+        bool                    m_Ok;               ///< false after any error of the sink
+        std::vector<char>       m_Buffer;           ///< block being filled
+        size_t                  m_BufPos;           ///< number of used bytes in the block
+        uint64_t                m_Flushed;          ///< number of bytes handed to the sink
+        int                     m_FloatPrecision;   ///< significant digits of floating point values, 0 - shortest round-trip
+        EControlChars           m_ControlChars;     ///< handling of the characters not allowed in XML
+
+        //Disable copy and assignment
+        XMLWriter( const XMLWriter & );
+        XMLWriter & operator=( const XMLWriter & );
+
+        inline void Init( size_t BufferSize )
         {
-            assert( ! FileName.empty() );
 #ifndef NDEBUG
             m_LightTagCounter = 0;
 #endif
-            m_OStream.open( FileName.c_str(), std::ios_base::out );
-            m_OStream.imbue( std::locale( "C" ) );
-            SetFloatPrecision( std::numeric_limits<double>::digits10 + 1 );
-            m_OStream << "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n";
+            m_Ok = true;
+            m_Tags.reserve( 32 );
+            m_Buffer.resize( BufferSize < 64 ? 64 : BufferSize );
+            m_BufPos = 0;
+            m_Flushed = 0;
+            m_FloatPrecision = 0;
+            m_ControlChars = CONTROL_CHARS_STRIP;
+            static const char Header[] = "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n";
+            Write( Header, sizeof( Header ) - 1 );
+        }
+
+        inline void FlushBuffer()
+        {
+            if( m_BufPos == 0 )
+                return;
+            if( ! m_Sink->Write( & m_Buffer[ 0 ], m_BufPos ) )
+                m_Ok = false;
+            m_Flushed += m_BufPos;
+            m_BufPos = 0;
+        }
+
+        inline void Put( char Ch )
+        {
+            if( m_BufPos == m_Buffer.size() )
+                FlushBuffer();
+            m_Buffer[ m_BufPos++ ] = Ch;
+        }
+
+        inline void Write( const char * Str, size_t Len )
+        {
+            if( Len > m_Buffer.size() - m_BufPos )
+            {
+                FlushBuffer();
+                if( Len >= m_Buffer.size() )    //Too big for the block, pass through
+                {
+                    if( ! m_Sink->Write( Str, Len ) )
+                        m_Ok = false;
+                    m_Flushed += Len;
+                    return;
+                }
+            }
+            std::memcpy( & m_Buffer[ m_BufPos ], Str, Len );
+            m_BufPos += Len;
+        }
+
+        inline void WriteStr( const char * Str )
+        {
+            Write( Str, std::strlen( Str ) );
         }
 
         inline void CloseOpenedTag()
         {
             if( ! m_TagOpen )
                 return;
-            m_OStream.put( '>' );
+            Put( '>' );
             m_TagOpen = false;
         }
 
-        inline void WriteStringEscape( const char * String )
+        //Copies runs of ordinary characters as is, escapes the markup characters,
+        //replaces invalid UTF-8 bytes with U+FFFD and strips or encodes the characters not allowed in XML
+        inline void WriteStringEscape( const char * String, size_t Len )
         {
-            for( ; * String; String++ )
-                switch( * String )
+            const char * const End = String + Len;
+            const bool Encode = m_ControlChars == CONTROL_CHARS_ENCODE;
+            const char * Run = String;  //Begin of the characters without escaping
+            for( const char * Pos = String; ; )
+            {
+                Pos = XMLEscape::FindSpecial( Pos, End, Encode );
+                if( Pos == End )
+                    break;
+                const unsigned char Ch = static_cast< unsigned char >( * Pos );
+                const char * Entity = NULL;
+                size_t EntityLen = 0, SkipLen = 1;
+                char Tmp[ 8 ];
+                switch( Ch )
                 {
-                    case '&'    :   m_OStream << "&amp;";        break;
-                    case '<'    :   m_OStream << "&lt;";         break;
-                    case '>'    :   m_OStream << "&gt;";         break;
-                    case '\''   :   m_OStream << "&apos;";       break;
-                    case '"'    :   m_OStream << "&quot;";       break;
-                    default     :   m_OStream.put( * String );   break;
+                    case '&'    :   Entity = "&amp;";   EntityLen = 5;  break;
+                    case '<'    :   Entity = "&lt;";    EntityLen = 4;  break;
+                    case '>'    :   Entity = "&gt;";    EntityLen = 4;  break;
+                    case '\''   :   Entity = "&apos;";  EntityLen = 6;  break;
+                    case '"'    :   Entity = "&quot;";  EntityLen = 6;  break;
+                    case '\t'   :
+                    case '\n'   :
+                    case '\r'   :   Pos++;  continue;
+                    case '_'    :
+                        if( ! XMLEscape::IsHexEscape( Pos, End ) )
+                        {
+                            Pos++;
+                            continue;
+                        }
+                        Entity = "_x005F_";
+                        EntityLen = 7;
+                        break;
+                    default     :
+                        if( Ch < 0x80 )     //Control character
+                        {
+                            if( Encode )
+                            {
+                                EntityLen = XMLEscape::HexEscape( Ch, Tmp );
+                                Entity = Tmp;
+                            }
+                        }
+                        else
+                        {
+                            uint32_t CodePoint = 0;
+                            SkipLen = XMLEscape::UTF8Sequence( Pos, End, CodePoint );
+                            if( SkipLen == 0 )
+                            {
+                                Entity = "\xEF\xBF\xBD";    //U+FFFD Replacement Character
+                                EntityLen = 3;
+                                SkipLen = 1;
+                            }
+                            else if( ( CodePoint == 0xFFFE ) || ( CodePoint == 0xFFFF ) )
+                            {
+                                if( Encode )
+                                {
+                                    EntityLen = XMLEscape::HexEscape( CodePoint, Tmp );
+                                    Entity = Tmp;
+                                }
+                            }
+                            else
+                            {
+                                Pos += SkipLen;
+                                continue;
+                            }
+                        }
+                        break;
                 }
+                Write( Run, Pos - Run );
+                if( EntityLen != 0 )
+                    Write( Entity, EntityLen );
+                Pos += SkipLen;
+                Run = Pos;
+            }
+            Write( Run, End - Run );
+        }
+
+        inline XMLWriter & TagOnlyContentInt( const char * TagName, const char * ContentString, size_t Len )
+        {
+            assert( TagName != NULL );
+            CloseOpenedTag();
+            DebugCheckIsLightTagOpened();
+            Put( '<' );
+            WriteStr( TagName );
+            Put( '>' );
+            WriteStringEscape( ContentString, Len );
+            Write( "</", 2 );
+            WriteStr( TagName );
+            Put( '>' );
+            m_SelfClosed = false;
+            return * this;
+        }
+
+        inline XMLWriter & ContInt( const char * String, size_t Len )
+        {
+            CloseOpenedTag();
+            DebugCheckIsLightTagOpened();
+            WriteStringEscape( String, Len );
+            m_SelfClosed = false;
+            return * this;
         }
 
-        //Write an attribute for the current Tag
         inline XMLWriter & AttrInt( const char * AttrName, const char * String )
+        {
+            return AttrInt( AttrName, String, std::strlen( String ) );
+        }
+
+        inline XMLWriter & AttrInt( const char * AttrName, const char * String, size_t Len )
         {
             assert( AttrName != NULL );
             assert( m_TagOpen );
-            m_OStream << ' ' << AttrName << "=\"";
-            WriteStringEscape( String );
-            m_OStream.put( '"' );
+            Put( ' ' );
+            WriteStr( AttrName );
+            Write( "=\"", 2 );
+            WriteStringEscape( String, Len );
+            Put( '"' );
             return * this;
         }
 
+        // *INDENT-OFF*   For AStyle tool
+        inline void WriteValue( const char * Value )        { WriteStr( Value ); }
+        inline void WriteValue( const std::string & Value ) { Write( Value.c_str(), Value.size() ); }
+        inline void WriteValue( int Value )                 { WriteInt( Value ); }
+        inline void WriteValue( long Value )                { WriteInt( Value ); }
+        inline void WriteValue( long long Value )           { WriteInt( Value ); }
+        inline void WriteValue( unsigned int Value )        { WriteUInt( Value ); }
+        inline void WriteValue( unsigned long Value )       { WriteUInt( Value ); }
+        inline void WriteValue( unsigned long long Value )  { WriteUInt( Value ); }
+        inline void WriteValue( float Value )               { WriteFloat( Value ); }
+        inline void WriteValue( double Value )              { WriteDouble( Value ); }
+        // *INDENT-ON*   For AStyle tool
+
+        //WriteValue() template for all other streamable types
+        template <typename _T>
+        inline void WriteValue( const _T & Value )
+        {
+            std::ostringstream Stream;
+            Stream.imbue( std::locale::classic() );
+            Stream.precision( m_FloatPrecision != 0 ? m_FloatPrecision : std::numeric_limits<double>::digits10 + 1 );
+            Stream << Value;
+            const std::string Str = Stream.str();
+            Write( Str.c_str(), Str.size() );
+        }
+
+        inline void WriteUInt( uint64_t Value )
+        {
+            char Buffer[ NumberToChars::BufferSize ];
+            Write( Buffer, NumberToChars::UInt( Value, Buffer ) );
+        }
+
+        inline void WriteInt( int64_t Value )
+        {
+            char Buffer[ NumberToChars::BufferSize ];
+            Write( Buffer, NumberToChars::Int( Value, Buffer ) );
+        }
+
+        inline void WriteDouble( double Value )
+        {
+            char Buffer[ NumberToChars::BufferSize ];
+            if( m_FloatPrecision == 0 )
+                Write( Buffer, NumberToChars::Double( Value, Buffer ) );
+            else Write( Buffer, NumberToChars::Precision( Value, m_FloatPrecision, Buffer ) );
+        }
+
+        inline void WriteFloat( float Value )
+        {
+            char Buffer[ NumberToChars::BufferSize ];
+            if( m_FloatPrecision == 0 )
+                Write( Buffer, NumberToChars::Float( Value, Buffer ) );
+            else Write( Buffer, NumberToChars::Precision( Value, m_FloatPrecision, Buffer ) );
+        }
+
         //Debug version for checking TagL and EndL
 #ifdef NDEBUG
         inline void DebugCheckAndIncLightTag()      {}
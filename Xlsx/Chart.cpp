@@ -507,9 +507,9 @@ void CChart::AddLineChart( XMLWriter & xmlw, Axis & xAxis, uint32_t yAxisId, con
                 default:;
             }
             xmlw.Tag( "c:spPr" ).Tag( "a:ln" ).Attr( "w", floor( it->LineWidth * 12700 ) );
-            if( it->LineColor.size() == 6 )
+            if( it->LineColor.IsSet() )
             {
-                xmlw.Tag( "a:solidFill" ).TagL( "a:srgbClr" ).Attr( "val", it->LineColor ).EndL().End( "a:solidFill" );
+                xmlw.Tag( "a:solidFill" ).TagL( "a:srgbClr" ).Attr( "val", it->LineColor.ToString( false ) ).EndL().End( "a:solidFill" );
             }
             xmlw.TagL( "a:prstDash" ).Attr( "val", dashID ).EndL().End( "a:ln" ).End( "c:spPr" );
 
@@ -588,7 +588,7 @@ void CChart::AddBarChart( XMLWriter & xmlw, Axis & xAxis, uint32_t yAxisId, cons
                 xmlw.Tag( "c:spPr" ).Tag( "a:noFill" ).End( "a:noFill" ).End( "c:spPr" );
                 break;
             case Series::BAR_FILL_SOLID:
-                xmlw.Tag( "c:spPr" ).Tag( "a:solidFill" ).Tag( "a:srgbClr" ).Attr( "val", it->LineColor );
+                xmlw.Tag( "c:spPr" ).Tag( "a:solidFill" ).Tag( "a:srgbClr" ).Attr( "val", it->LineColor.ToString( false ) );
                 xmlw.End( "a:srgbClr" ).End( "a:solidFill" ).End( "c:spPr" );
                 break;
             case Series::BAR_FILL_AUTOMATIC:
@@ -610,7 +610,7 @@ void CChart::AddBarChart( XMLWriter & xmlw, Axis & xAxis, uint32_t yAxisId, cons
                 case Series::BAR_FILL_SOLID:
                     xmlw.Tag( "c:extLst" ).Tag( "c:ext" ).Attr( "uri", "{6F2FDCE9-48DA-4B69-8628-5D25D57E5C99}" ).Attr( "xmlns:c14", ns_c14 );
                     xmlw.Tag( "c14:invertSolidFillFmt" ).Tag( "c14:spPr" ).Attr( "xmlns:c14", ns_c14 );
-                    xmlw.Tag( "a:solidFill" ).Tag( "a:srgbClr" ).Attr( "val", it->barInvertedColor ).End( "a:srgbClr" ).End( "a:solidFill" );
+                    xmlw.Tag( "a:solidFill" ).Tag( "a:srgbClr" ).Attr( "val", it->barInvertedColor.ToString( false ) ).End( "a:srgbClr" ).End( "a:solidFill" );
                     xmlw.End( "c14:spPr" ).End( "c14:invertSolidFillFmt" );
                     xmlw.End( "c:ext" ).End( "c:extLst" );
                     break;
@@ -702,9 +702,9 @@ void CChart::AddScatterChart( XMLWriter & xmlw, uint32_t xAxisId, uint32_t yAxis
                 default:;
             }
             xmlw.Tag( "c:spPr" ).Tag( "a:ln" ).Attr( "w", floor( it->LineWidth * 12700 ) );
-            if( it->LineColor.size() == 6 )
+            if( it->LineColor.IsSet() )
             {
-                xmlw.Tag( "a:solidFill" ).TagL( "a:srgbClr" ).Attr( "val", it->LineColor ).EndL().End( "a:solidFill" );
+                xmlw.Tag( "a:solidFill" ).TagL( "a:srgbClr" ).Attr( "val", it->LineColor.ToString( false ) ).EndL().End( "a:solidFill" );
             }
             xmlw.TagL( "a:prstDash" ).Attr( "val", dashID ).EndL().End( "a:ln" ).End( "c:spPr" );
 
@@ -780,15 +780,15 @@ void CChart::AddPieChart( XMLWriter & xmlw, const Diagramm & diagramm, const std
 void CChart::AddMarker( XMLWriter & xmlw, const CChart::Series & ser, const char * markerID )
 {
     xmlw.Tag( "c:marker" ).TagL( "c:symbol" ).Attr( "val", markerID ).EndL().TagL( "c:size" ).Attr( "val", ser.Marker.Size ).EndL();
-    const bool IsFillColor = ser.Marker.FillColor.size() == 6;
-    const bool IsLineColor = ser.Marker.LineColor.size() == 6;
-    if( IsFillColor || IsLineColor ) // check formal RGB record format
+    const bool IsFillColor = ser.Marker.FillColor.IsSet();
+    const bool IsLineColor = ser.Marker.LineColor.IsSet();
+    if( IsFillColor || IsLineColor )
     {
         xmlw.Tag( "c:spPr" );
         if( IsFillColor )
-            xmlw.Tag( "a:solidFill" ).TagL( "a:srgbClr" ).Attr( "val", ser.Marker.FillColor ).EndL().End( "a:solidFill" ); // marker fill
+            xmlw.Tag( "a:solidFill" ).TagL( "a:srgbClr" ).Attr( "val", ser.Marker.FillColor.ToString( false ) ).EndL().End( "a:solidFill" ); // marker fill
         if( IsLineColor )
-            xmlw.Tag( "a:ln" ).Attr( "w", floor( ser.Marker.LineWidth * 12700 ) ).Tag( "a:solidFill" ).TagL( "a:srgbClr" ).Attr( "val", ser.Marker.LineColor ).EndL().End( "a:solidFill" ).End( "a:ln" ); // marker line
+            xmlw.Tag( "a:ln" ).Attr( "w", floor( ser.Marker.LineWidth * 12700 ) ).Tag( "a:solidFill" ).TagL( "a:srgbClr" ).Attr( "val", ser.Marker.LineColor.ToString( false ) ).EndL().End( "a:solidFill" ).End( "a:ln" ); // marker line
         xmlw.End( "c:spPr" );
     }
     xmlw.End( "c:marker" );
@@ -902,8 +902,8 @@ void CChart::AddAreaFill( XMLWriter & xmlw, const CChart::AreaFill & areaFill )
         case PLOT_AREA_FILL_NONE    : break;
         case PLOT_AREA_FILL_SOLID   :
         {
-            if( areaFill.SolidColor.size() == 6 )
-                xmlw.Tag( "c:spPr" ).Tag( "a:solidFill" ).TagL( "a:srgbClr" ).Attr( "val", areaFill.SolidColor ).EndL().End( "a:solidFill" ).End( "c:spPr" );
+            if( areaFill.SolidColor.IsSet() )
+                xmlw.Tag( "c:spPr" ).Tag( "a:solidFill" ).TagL( "a:srgbClr" ).Attr( "val", areaFill.SolidColor.ToString( false ) ).EndL().End( "a:solidFill" ).End( "c:spPr" );
             break;
         }
         case PLOT_AREA_FILL_GRADIENT:
@@ -912,7 +912,7 @@ void CChart::AddAreaFill( XMLWriter & xmlw, const CChart::AreaFill & areaFill )
             const GradientFill & GF = areaFill.Gradient;
             GradientStops::const_iterator it = GF.ColorPoints.begin();
             for( ; it != GF.ColorPoints.end(); it++ )
-                xmlw.Tag( "a:gs" ).Attr( "pos", it->first * 1000 ).Tag( "a:srgbClr" ).Attr( "val", it->second ).End( "a:srgbClr" ).End( "a:gs" );
+                xmlw.Tag( "a:gs" ).Attr( "pos", it->first * 1000 ).Tag( "a:srgbClr" ).Attr( "val", it->second.ToString( false ) ).End( "a:srgbClr" ).End( "a:gs" );
             xmlw.End( "a:gsLst" );
             switch( GF.FillType )
             {
@@ -932,8 +932,8 @@ void CChart::AddAreaFill( XMLWriter & xmlw, const CChart::AreaFill & areaFill )
         case PLOT_AREA_FILL_PATTERN:
         {
             xmlw.Tag( "c:spPr" ).Tag( "a:pattFill" ).Attr( "prst", PatternPresetCode( areaFill.Pattern ) );
-            xmlw.Tag( "a:fgClr" ).TagL( "a:srgbClr" ).Attr( "val", areaFill.PatternFgColor ).EndL().End( "a:fgClr" );
-            xmlw.Tag( "a:bgClr" ).TagL( "a:srgbClr" ).Attr( "val", areaFill.PatternBgColor ).EndL().End( "a:bgClr" );
+            xmlw.Tag( "a:fgClr" ).TagL( "a:srgbClr" ).Attr( "val", areaFill.PatternFgColor.ToString( false ) ).EndL().End( "a:fgClr" );
+            xmlw.Tag( "a:bgClr" ).TagL( "a:srgbClr" ).Attr( "val", areaFill.PatternBgColor.ToString( false ) ).EndL().End( "a:bgClr" );
             xmlw.End( "a:pattFill" ).End( "c:spPr" );
             break;
         }
@@ -160,8 +160,8 @@ class CChart
         {
             private:
                 // int - Pos in Gradient stops from 0 to 100 in percent
-                // std::string - Color RGB string like "FF00FF"
-                typedef typename std::map< int, std::string > Container;
+                // Color - RGB color
+                typedef typename std::map< int, Color > Container;
 
                 Container m_Points;
 
@@ -176,10 +176,10 @@ class CChart
                 inline void Clear()                 { m_Points.clear(); }
                 // *INDENT-ON*   For AStyle tool
 
-                inline void Add( int Percent, const std::string & Color )
+                inline void Add( int Percent, Color PointColor )
                 {
                     assert( ( Percent >= 0 ) && ( Percent <= 100 ) );
-                    m_Points.insert( Container::value_type( Percent, Color ) );
+                    m_Points.insert( Container::value_type( Percent, PointColor ) );
                 }
         };
 
@@ -213,14 +213,12 @@ class CChart
             {
                 symType Type;			     				///< SymType indicates whether and how nodes are marked
                 size_t Size;                              ///< SymSize 1 ... 10(?)
-                std::string FillColor, LineColor;         ///< Color RGB string like "FF00FF"
+                Color FillColor, LineColor;               ///< Color RGB like "FF00FF"
                 double LineWidth;                         ///< Like in excell 0.5 ... 3.0(?)
                 stMarker()
                 {
                     Size = 7;
                     Type = symNone;
-                    FillColor = "";
-                    LineColor = "";
                     LineWidth = 0.5;
                 }
             } Marker;
@@ -235,7 +233,7 @@ class CChart
 
             joinType JoinType;						     	///< JoinType indicates whether series must be joined and smoothed at rendering
             double LineWidth;                               ///< Like in excell  0.5 ... 3.0 (?)
-            std::string LineColor;                          ///< LineGolor RGB string like "FF00FF"
+            Color LineColor;                                ///< LineGolor RGB like "FF00FF"
             dashType DashType;							    ///< DashType indicates whether line will be rendered dashed or not
 
             // Specific for bar chart
@@ -247,7 +245,7 @@ class CChart
             };
             BarFillStyle    barFillStyle;
             bool            barInvertIfNegative;            ///< Invert fill if negative data value
-            std::string     barInvertedColor;               ///< Golor RGB string like "FF00FF" if barInvertIfNegative = true
+            Color           barInvertedColor;               ///< Golor RGB like "FF00FF" if barInvertIfNegative = true
 
             DataLabels dataLabels;      ///< the settings for the data labels for an entire series
 
@@ -255,14 +253,12 @@ class CChart
             {
                 catSheet = NULL;
                 valSheet = NULL;
-                LineColor = "";
                 JoinType = joinNone;
                 LineWidth = 1.;
                 DashType = dashSolid;
 
                 barFillStyle = BAR_FILL_AUTOMATIC;
                 barInvertIfNegative = true;
-                barInvertedColor = "";
             }
         };
 
@@ -352,10 +348,10 @@ class CChart
         struct AreaFill
         {
             EPlotAreaFillStyle Style;
-            std::string SolidColor;         ///< SolidlColor RGB string like "FF00FF" for solid fill
+            Color SolidColor;               ///< SolidlColor RGB like "FF00FF" for solid fill
             GradientFill Gradient;          ///< Params for a gradient fill
             EPatternFillStyle Pattern;
-            std::string PatternFgColor, PatternBgColor;
+            Color PatternFgColor, PatternBgColor;
 
             void SetLinearGradient( double Angle, bool ScaleAngle, const GradientStops & Stops )
             {
@@ -379,7 +375,7 @@ class CChart
                 Gradient.ColorPoints = Stops;
             }
 
-            void SetPattern( EPatternFillStyle PatternStyle, const std::string & FgColor, const std::string & BgColor )
+            void SetPattern( EPatternFillStyle PatternStyle, Color FgColor, Color BgColor )
             {
                 Style = PLOT_AREA_FILL_PATTERN;
                 Pattern = PatternStyle;
@@ -476,7 +472,7 @@ class CChart
 
 
         inline CChart & SetPlotAreaFillNone()               { m_diagramm.plotAreaFill.Style = PLOT_AREA_FILL_NONE; return * this; }
-        inline CChart & SetPlotAreaFillSolid( std::string fillColor )
+        inline CChart & SetPlotAreaFillSolid( Color fillColor )
                                                             {
                                                               m_diagramm.plotAreaFill.Style = PLOT_AREA_FILL_SOLID;
                                                               m_diagramm.plotAreaFill.SolidColor = fillColor;
@@ -508,7 +504,7 @@ class CChart
                                                               m_diagramm.plotAreaFill.SetPathGradient( Stops );
                                                               return * this;
                                                             }
-        inline CChart & SetPlotAreaFillPattern( EPatternFillStyle PatternStyle, const std::string & FgColor, const std::string & BgColor )
+        inline CChart & SetPlotAreaFillPattern( EPatternFillStyle PatternStyle, Color FgColor, Color BgColor )
                                                             {
                                                               m_diagramm.plotAreaFill.SetPattern( PatternStyle, FgColor, BgColor );
                                                               return * this;
@@ -516,7 +512,7 @@ class CChart
 
 
         inline CChart & SetChartAreaFillNone()              { m_diagramm.chartAreaFill.Style = PLOT_AREA_FILL_NONE; return * this; }
-        inline CChart & SetChartAreaFillSolid( std::string fillColor )
+        inline CChart & SetChartAreaFillSolid( Color fillColor )
                                                             {
                                                               m_diagramm.chartAreaFill.Style = PLOT_AREA_FILL_SOLID;
                                                               m_diagramm.chartAreaFill.SolidColor = fillColor;
@@ -548,7 +544,7 @@ class CChart
                                                               m_diagramm.chartAreaFill.SetPathGradient( Stops );
                                                               return * this;
                                                             }
-        inline CChart & SetChartAreaFillPattern( EPatternFillStyle PatternStyle, const std::string & FgColor, const std::string & BgColor )
+        inline CChart & SetChartAreaFillPattern( EPatternFillStyle PatternStyle, Color FgColor, Color BgColor )
                                                             {
                                                               m_diagramm.chartAreaFill.SetPattern( PatternStyle, FgColor, BgColor );
                                                               return * this;
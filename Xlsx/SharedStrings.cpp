@@ -0,0 +1,443 @@
+/*
+  SimpleXlsxWriter
+  Copyright (C) 2012-2021 Pavel Akimov <oxod.pavel@gmail.com>, Alexandr Belyak <programmeralex@bk.ru>
+
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <cmath>
+#include <limits>
+
+#include "SharedStrings.h"
+
+#include "../XMLWriter.hpp"
+
+namespace SimpleXlsx
+{
+const uint32_t SharedStringTable::FreeSlot;
+
+SharedStringTable::SharedStringTable() : m_BlockPos( NULL ), m_BlockLeft( 0 ), m_BlockSize( MinBlockSize ),
+    m_Streamed( false ), m_Stream( NULL ), m_StreamedCount( 0 ), m_VerifyFile( NULL ), m_VerifyTailOffset( 0 ),
+    m_Window( 0 ), m_ClockHand( 0 ),
+    m_Lookups( 0 ), m_Hits( 0 ), m_Evictions( 0 )
+{
+}
+
+SharedStringTable::~SharedStringTable()
+{
+    for( std::vector<char *>::iterator it = m_Blocks.begin(); it != m_Blocks.end(); it++ )
+        delete[] * it;
+    if( m_VerifyFile != NULL )
+        fclose( m_VerifyFile );
+}
+
+// ****************************************************************************
+/// @brief	Prepares the table for the expected number of the strings
+/// @param	Count expected number of the unique strings
+/// @param	TotalLength expected length of all unique strings (0 if unknown)
+/// @return	no
+/// @note	With the right hints the hash table is never rebuilt and the arena is one block
+// ****************************************************************************
+void SharedStringTable::Reserve( size_t Count, size_t TotalLength )
+{
+    size_t SlotCount = 16;
+    while( SlotCount * 7 < Count * 10 )   // load factor up to 0.7
+        SlotCount *= 2;
+    if( m_Streamed )
+    {
+        m_Fingerprints.reserve( Count );
+        if( SlotCount > m_Slots.size() )
+            RehashFingerprints( SlotCount );
+        return;
+    }
+    m_Entries.reserve( Count );
+    if( SlotCount > m_Slots.size() )
+        Rehash( SlotCount );
+    if( TotalLength > m_BlockLeft )
+    {
+        m_BlockPos = AllocBlock( TotalLength );
+        m_BlockLeft = TotalLength;
+    }
+}
+
+// ****************************************************************************
+/// @brief	Switches the empty table to the streamed mode
+/// @param	Stream writer of xl/sharedStrings.xml with the opened sst element
+/// @param	Window maximum number of the remembered strings, 0 - unbounded
+/// @return	no
+/// @note	If the temporary verification file cannot be created, the texts are kept in memory.
+///         The bounded window keeps the texts of its strings in memory and uses no file.
+// ****************************************************************************
+void SharedStringTable::StartStream( XMLWriter & Stream, size_t Window )
+{
+    assert( Empty() );
+    assert( Window < 0xFFFFFFFF );
+    m_Streamed = true;
+    m_Stream = & Stream;
+    m_Window = Window;
+    if( m_Window == 0 )
+    {
+        m_VerifyFile = tmpfile();
+        if( m_VerifyFile != NULL )
+            setvbuf( m_VerifyFile, NULL, _IONBF, 0 );   // the texts are written in large pieces and read back randomly
+        Reserve( m_Entries.capacity() );
+        return;
+    }
+    size_t SlotCount = 16;
+    while( SlotCount * 7 < m_Window * 10 )   // load factor up to 0.7
+        SlotCount *= 2;
+    m_WindowSlots.assign( SlotCount, FreeSlot );
+    m_WindowEntries.reserve( m_Window );
+    m_WindowReferenced.reserve( m_Window );
+}
+
+// ****************************************************************************
+/// @brief	Completes the streamed mode, no strings can be added after it
+/// @return	no
+// ****************************************************************************
+void SharedStringTable::EndStream()
+{
+    m_Stream = NULL;
+    if( m_VerifyFile != NULL )
+        fclose( m_VerifyFile );
+    m_VerifyFile = NULL;
+    std::vector<char>().swap( m_VerifyTail );
+    std::vector<char>().swap( m_ReadBack );
+    std::vector<WindowEntry>().swap( m_WindowEntries );
+}
+
+// ****************************************************************************
+/// @brief	Returns the statistics of the lookups
+/// @return	Statistics
+// ****************************************************************************
+SharedStringStats SharedStringTable::GetStats() const
+{
+    const SharedStringStats Result = { m_Lookups, m_Hits, m_Evictions, Size(), m_Window };
+    return Result;
+}
+
+// ****************************************************************************
+/// @brief	Returns the index of the string, adds the copy of the string if it is new
+/// @param	Str pointer to the string (may be not null-terminated)
+/// @param	Len length of the string
+/// @return	Index of the string
+// ****************************************************************************
+uint64_t SharedStringTable::AddStored( const char * Str, size_t Len )
+{
+    m_Lookups++;
+    assert( Len <= 0xFFFFFFFF );
+    if( m_Entries.size() * 10 >= m_Slots.size() * 7 )
+        Rehash( m_Slots.empty() ? 1024 : m_Slots.size() * 2 );
+
+    const uint32_t StrHash = static_cast<uint32_t>( Hash( Str, Len ) );
+    const size_t Mask = m_Slots.size() - 1;
+    size_t Pos = StrHash & Mask;
+    for( ; m_Slots[ Pos ] != FreeSlot; Pos = ( Pos + 1 ) & Mask )    // linear probing
+    {
+        const Entry & E = m_Entries[ m_Slots[ Pos ] - 1 ];
+        if( ( E.Hash == StrHash ) && ( E.Len == Len ) && ( std::memcmp( E.Str, Str, Len ) == 0 ) )
+        {
+            m_Hits++;
+            return m_Slots[ Pos ] - 1;
+        }
+    }
+
+    const uint64_t Index = m_Entries.size();
+    assert( Index < 0xFFFFFFFF );
+    const Entry NewEntry = { Store( Str, Len ), static_cast<uint32_t>( Len ), StrHash };
+    m_Entries.push_back( NewEntry );
+    m_Slots[ Pos ] = static_cast<uint32_t>( Index + 1 );
+    return Index;
+}
+
+// ****************************************************************************
+/// @brief	Returns the index of the string, writes the string to the stream if it is new
+/// @param	Str pointer to the string (may be not null-terminated)
+/// @param	Len length of the string
+/// @return	Index of the string
+/// @note	The text of the string with the same hash is compared too, so the index is never
+///         shared by the different strings
+// ****************************************************************************
+uint64_t SharedStringTable::AddStreamed( const char * Str, size_t Len )
+{
+    if( m_Window != 0 )
+        return AddWindowed( Str, Len );
+    m_Lookups++;
+    assert( Len <= 0xFFFFFFFF );
+    if( m_Fingerprints.size() * 10 >= m_Slots.size() * 7 )
+        RehashFingerprints( m_Slots.empty() ? 1024 : m_Slots.size() * 2 );
+
+    const uint32_t StrHash = static_cast<uint32_t>( Hash( Str, Len ) );
+    const size_t Mask = m_Slots.size() - 1;
+    size_t Pos = StrHash & Mask;
+    for( ; m_Slots[ Pos ] != FreeSlot; Pos = ( Pos + 1 ) & Mask )    // linear probing
+    {
+        Fingerprint & F = m_Fingerprints[ m_Slots[ Pos ] - 1 ];
+        if( ( F.Hash == StrHash ) && SameText( F, Str, Len ) )
+        {
+            m_Hits++;
+            return m_Slots[ Pos ] - 1;
+        }
+    }
+
+    const uint64_t Index = WriteStreamed( Str, Len );
+    const Fingerprint NewFingerprint = { Remember( Str, Len ), static_cast<uint32_t>( Len ), StrHash };
+    m_Fingerprints.push_back( NewFingerprint );
+    m_Slots[ Pos ] = static_cast<uint32_t>( Index + 1 );
+    return Index;
+}
+
+// ****************************************************************************
+/// @brief	Returns the index of the string in the bounded window, writes the string to the stream if it is not there
+/// @param	Str pointer to the string (may be not null-terminated)
+/// @param	Len length of the string
+/// @return	Index of the string
+/// @note	The window is full after m_Window new strings. Then the CLOCK hand evicts the first
+///         string that was not found since the hand passed it last time, and the new text takes
+///         the buffer of the evicted one.
+// ****************************************************************************
+uint64_t SharedStringTable::AddWindowed( const char * Str, size_t Len )
+{
+    m_Lookups++;
+    assert( Len <= 0xFFFFFFFF );
+    const uint32_t StrHash = static_cast<uint32_t>( Hash( Str, Len ) );
+    const size_t Mask = m_WindowSlots.size() - 1;
+    for( size_t Pos = StrHash & Mask; m_WindowSlots[ Pos ] != FreeSlot; Pos = ( Pos + 1 ) & Mask )
+    {
+        const size_t Entry = m_WindowSlots[ Pos ] - 1;
+        const WindowEntry & E = m_WindowEntries[ Entry ];
+        if( ( E.Hash == StrHash ) && ( E.Text.size() == Len ) && ( std::memcmp( E.Text.data(), Str, Len ) == 0 ) )
+        {
+            m_Hits++;
+            m_WindowReferenced[ Entry ] = 1;
+            return E.Index;
+        }
+    }
+
+    size_t Entry = m_WindowEntries.size();
+    if( Entry < m_Window )
+    {
+        m_WindowEntries.push_back( WindowEntry() );
+        m_WindowReferenced.push_back( 0 );
+    }
+    else
+    {
+        while( m_WindowReferenced[ m_ClockHand ] != 0 )    // second chance
+        {
+            m_WindowReferenced[ m_ClockHand ] = 0;
+            m_ClockHand = ( m_ClockHand + 1 ) % m_Window;
+        }
+        Entry = m_ClockHand;
+        m_ClockHand = ( m_ClockHand + 1 ) % m_Window;
+        RemoveWindowSlot( Entry );
+        m_Evictions++;
+    }
+
+    WindowEntry & E = m_WindowEntries[ Entry ];
+    if( E.Text.capacity() > 2 * Len + 64 )     // a long evicted text does not keep its large buffer
+        std::string( Str, Len ).swap( E.Text );
+    else
+        E.Text.assign( Str, Len );
+    E.Hash = StrHash;
+    E.Index = static_cast<uint32_t>( WriteStreamed( Str, Len ) );
+    m_WindowReferenced[ Entry ] = 0;
+    size_t Pos = StrHash & Mask;
+    while( m_WindowSlots[ Pos ] != FreeSlot )
+        Pos = ( Pos + 1 ) & Mask;
+    m_WindowSlots[ Pos ] = static_cast<uint32_t>( Entry + 1 );
+    return E.Index;
+}
+
+//Deletes the slot of the window entry, the following slots of the probe sequence are moved back (no tombstones)
+void SharedStringTable::RemoveWindowSlot( size_t Entry )
+{
+    const size_t Mask = m_WindowSlots.size() - 1;
+    size_t Hole = m_WindowEntries[ Entry ].Hash & Mask;
+    while( m_WindowSlots[ Hole ] != Entry + 1 )
+        Hole = ( Hole + 1 ) & Mask;
+    for( size_t Pos = ( Hole + 1 ) & Mask; m_WindowSlots[ Pos ] != FreeSlot; Pos = ( Pos + 1 ) & Mask )
+    {
+        const size_t Home = m_WindowEntries[ m_WindowSlots[ Pos ] - 1 ].Hash & Mask;
+        if( ( ( Pos - Home ) & Mask ) >= ( ( Pos - Hole ) & Mask ) )    // the hole is between Home and Pos
+        {
+            m_WindowSlots[ Hole ] = m_WindowSlots[ Pos ];
+            Hole = Pos;
+        }
+    }
+    m_WindowSlots[ Hole ] = FreeSlot;
+}
+
+//Writes the new entry of the streamed sst, returns its index
+uint64_t SharedStringTable::WriteStreamed( const char * Str, size_t Len )
+{
+    assert( m_Stream != NULL );
+    const uint64_t Index = m_StreamedCount++;
+    assert( Index < 0xFFFFFFFF );
+    m_Stream->Fragment().Lit( "<si><t>" ).Text( Str, Len ).Lit( "</t></si>" );
+    return Index;
+}
+
+//Positions the file at the 64-bit offset, fseek takes long offsets (32 bits on Windows)
+static bool SeekFile( FILE * File, uint64_t Offset )
+{
+#ifdef _WIN32
+    if( Offset > static_cast<uint64_t>( std::numeric_limits<__int64>::max() ) )
+        return false;
+    return _fseeki64( File, static_cast<__int64>( Offset ), SEEK_SET ) == 0;
+#else
+    if( Offset > static_cast<uint64_t>( std::numeric_limits<off_t>::max() ) )
+        return false;
+    return fseeko( File, static_cast<off_t>( Offset ), SEEK_SET ) == 0;
+#endif
+}
+
+//Appends the text of the streamed string to the verification file, returns its offset there
+uint64_t SharedStringTable::Remember( const char * Str, size_t Len )
+{
+    assert( Len <= 0xFFFFFFFF );
+    if( ( m_VerifyFile != NULL ) && ( m_VerifyTail.size() + Len > VerifyTailSize ) && ! m_VerifyTail.empty() )
+    {
+        if( SeekFile( m_VerifyFile, m_VerifyTailOffset ) &&
+                ( fwrite( m_VerifyTail.data(), 1, m_VerifyTail.size(), m_VerifyFile ) == m_VerifyTail.size() ) )
+        {
+            m_VerifyTailOffset += m_VerifyTail.size();
+            m_VerifyTail.clear();
+        }
+        else
+        {
+            fclose( m_VerifyFile );     // The strings with the texts in the file will get new entries
+            m_VerifyFile = NULL;
+        }
+    }
+    const uint64_t Offset = m_VerifyTailOffset + m_VerifyTail.size();
+    m_VerifyTail.insert( m_VerifyTail.end(), Str, Str + Len );
+    return Offset;
+}
+
+//Checks that the string has the text of the fingerprint, the unreadable text is treated as different.
+//The text read back from the file is kept in memory for the next checks.
+bool SharedStringTable::SameText( Fingerprint & F, const char * Str, size_t Len )
+{
+    if( F.Len != Len )
+        return false;
+    if( Len == 0 )
+        return true;
+    if( ( F.Offset & ReadBack ) != 0 )
+        return std::memcmp( m_ReadBack.data() + ( F.Offset & ~ReadBack ), Str, Len ) == 0;
+    if( F.Offset >= m_VerifyTailOffset )
+        return std::memcmp( m_VerifyTail.data() + ( F.Offset - m_VerifyTailOffset ), Str, Len ) == 0;
+    if( m_VerifyFile == NULL )
+        return false;
+    const size_t Pos = m_ReadBack.size();
+    m_ReadBack.resize( Pos + Len );
+    if( ! SeekFile( m_VerifyFile, F.Offset ) || ( fread( m_ReadBack.data() + Pos, 1, Len, m_VerifyFile ) != Len ) )
+    {
+        m_ReadBack.resize( Pos );
+        return false;
+    }
+    F.Offset = ReadBack | Pos;
+    return std::memcmp( m_ReadBack.data() + Pos, Str, Len ) == 0;
+}
+
+void SharedStringTable::RehashFingerprints( size_t SlotCount )
+{
+    m_Slots.assign( SlotCount, FreeSlot );
+    const size_t Mask = SlotCount - 1;
+    for( size_t i = 0; i < m_Fingerprints.size(); i++ )
+    {
+        size_t Pos = m_Fingerprints[ i ].Hash & Mask;
+        while( m_Slots[ Pos ] != FreeSlot )
+            Pos = ( Pos + 1 ) & Mask;
+        m_Slots[ Pos ] = static_cast<uint32_t>( i + 1 );
+    }
+}
+
+void SharedStringTable::Rehash( size_t SlotCount )
+{
+    m_Slots.assign( SlotCount, FreeSlot );
+    const size_t Mask = SlotCount - 1;
+    for( size_t i = 0; i < m_Entries.size(); i++ )
+    {
+        size_t Pos = m_Entries[ i ].Hash & Mask;
+        while( m_Slots[ Pos ] != FreeSlot )
+            Pos = ( Pos + 1 ) & Mask;
+        m_Slots[ Pos ] = static_cast<uint32_t>( i + 1 );
+    }
+}
+
+// ****************************************************************************
+/// @brief	Copies the characters into the arena
+/// @param	Str pointer to the string
+/// @param	Len length of the string
+/// @return	Pointer to the copy
+/// @note	Long strings get their own blocks, so the tail of the current block is not wasted
+// ****************************************************************************
+const char * SharedStringTable::Store( const char * Str, size_t Len )
+{
+    if( Len == 0 )
+        return "";
+    if( Len > m_BlockLeft )
+    {
+        if( Len > MinBlockSize / 8 )
+        {
+            char * Block = AllocBlock( Len );
+            std::memcpy( Block, Str, Len );
+            return Block;
+        }
+        m_BlockPos = AllocBlock( m_BlockSize );
+        m_BlockLeft = m_BlockSize;
+        if( m_BlockSize < MaxBlockSize )
+            m_BlockSize *= 2;
+    }
+    char * Result = m_BlockPos;
+    std::memcpy( Result, Str, Len );
+    m_BlockPos += Len;
+    m_BlockLeft -= Len;
+    return Result;
+}
+
+char * SharedStringTable::AllocBlock( size_t Size )
+{
+    m_Blocks.reserve( m_Blocks.size() + 1 );    // no leak if push_back throws
+    char * Block = new char[ Size ];
+    m_Blocks.push_back( Block );
+    return Block;
+}
+
+// ****************************************************************************
+/// @brief	Returns the estimated number of the distinct strings added
+/// @return	Number of the distinct strings
+/// @note	Linear counting is used for the small numbers, when some registers are still empty
+// ****************************************************************************
+uint64_t StringCardinality::Estimate() const
+{
+    const double M = static_cast<double>( RegisterCount );
+    double Sum = 0.0;
+    size_t Zeros = 0;
+    for( size_t i = 0; i < RegisterCount; i++ )
+    {
+        Sum += std::ldexp( 1.0, -m_Registers[ i ] );
+        if( m_Registers[ i ] == 0 )
+            Zeros++;
+    }
+    double Result = ( 0.7213 / ( 1.0 + 1.079 / M ) ) * M * M / Sum;
+    if( ( Result <= 2.5 * M ) && ( Zeros > 0 ) )
+        Result = M * std::log( M / static_cast<double>( Zeros ) );
+    return static_cast<uint64_t>( Result + 0.5 );
+}
+
+} // namespace SimpleXlsx
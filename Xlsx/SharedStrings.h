@@ -0,0 +1,226 @@
+/*
+  SimpleXlsxWriter
+  Copyright (C) 2012-2021 Pavel Akimov <oxod.pavel@gmail.com>, Alexandr Belyak <programmeralex@bk.ru>
+
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef XLSX_SHAREDSTRINGS_H
+#define XLSX_SHAREDSTRINGS_H
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "SimpleXlsxDef.h"
+#include "../ByteHash.hpp"
+
+namespace SimpleXlsx
+{
+class XMLWriter;
+
+// ****************************************************************************
+/// @brief	Statistics of the shared strings, see CWorkbook::GetSharedStringStats
+// ****************************************************************************
+struct SharedStringStats
+{
+    uint64_t    lookups;    ///< strings added by the cells
+    uint64_t    hits;       ///< strings found in the table
+    uint64_t    evictions;  ///< strings forgotten by the bounded window
+    uint64_t    entries;    ///< entries of xl/sharedStrings.xml (the repeated strings are counted after the eviction)
+    size_t      window;     ///< maximum number of the remembered strings, 0 - unbounded
+};
+
+// ****************************************************************************
+/// @brief	Index of the string registered in the shared strings, see CWorkbook::RegisterSharedString
+/// @note	Cells with the handle refer to the index directly, the string is not looked up again.
+///         The handle is valid only for the workbook where it is registered.
+// ****************************************************************************
+class SharedStringHandle
+{
+    public:
+        // *INDENT-OFF*   For AStyle tool
+        inline SharedStringHandle() : m_Index( InvalidIndex ) {}
+        inline explicit SharedStringHandle( uint64_t Index ) : m_Index( Index ) {}
+
+        inline bool     IsValid() const     { return m_Index != InvalidIndex; }
+        inline uint64_t Index() const       { return m_Index; }
+        // *INDENT-ON*   For AStyle tool
+
+    private:
+        static const uint64_t InvalidIndex = ~uint64_t( 0 );
+
+        uint64_t    m_Index;
+};
+
+// ****************************************************************************
+/// @brief	The table of the unique cell strings of the workbook (xl/sharedStrings.xml)
+/// @note	Strings are looked up by the pointer and the length in the open-addressing hash table,
+///         the characters of a new string are copied once into the large blocks of the string arena.
+///         In the streamed mode the new strings are written to the stream at once and only their
+///         fingerprints (the hash and the place of the text in the verification file) are kept in memory.
+///         The texts are appended to the temporary verification file, a string with the matching hash
+///         gets the index of the fingerprint only when the text read back is the same. A text read back
+///         is kept in memory, so only the texts of the strings that repeat are held in memory and each
+///         of them is read from the file once.
+///         With the bounded window only the given number of the strings is remembered, their texts are
+///         kept in memory and no file is used: the least recently used strings are evicted (CLOCK),
+///         and a forgotten string gets a new entry.
+// ****************************************************************************
+class SharedStringTable
+{
+    public:
+        SharedStringTable();
+        ~SharedStringTable();
+
+        //Prepares the table for Count strings with TotalLength characters altogether (0 if unknown)
+        void Reserve( size_t Count, size_t TotalLength = 0 );
+
+        //Returns the index of the string, adds the string if it is new
+        inline uint64_t Add( const char * Str, size_t Len )
+        {
+            return m_Streamed ? AddStreamed( Str, Len ) : AddStored( Str, Len );
+        }
+
+        //Streamed mode: the new strings are written to the Stream as <si> elements (with sst opened).
+        //Window limits the number of the remembered strings, 0 - all strings are remembered.
+        //Must be started while the table is empty, the Stream must stay alive until EndStream().
+        void StartStream( XMLWriter & Stream, size_t Window = 0 );
+        void EndStream();
+
+        // *INDENT-OFF*   For AStyle tool
+        inline uint64_t Add( const char * Str )                 { return Add( Str, std::strlen( Str ) ); }
+        inline uint64_t Add( const std::string & Str )          { return Add( Str.data(), Str.size() ); }
+#ifdef SIMPLE_XLSX_STRING_VIEW
+        inline uint64_t Add( std::string_view Str )             { return Add( Str.data(), Str.size() ); }
+#endif
+
+        inline bool         Empty() const                       { return Size() == 0; }
+        inline size_t       Size() const                        { return m_Streamed ? m_StreamedCount : m_Entries.size(); }
+        inline bool         IsStreamed() const                  { return m_Streamed; }
+        SharedStringStats   GetStats() const;
+        // Strings in the order of their indices, not null-terminated (not available in the streamed mode)
+        inline const char * String( size_t Index ) const        { return m_Entries[ Index ].Str; }
+        inline size_t       Length( size_t Index ) const        { return m_Entries[ Index ].Len; }
+        // *INDENT-ON*   For AStyle tool
+
+        static inline uint64_t Hash( const char * Str, size_t Len )    { return ByteHash::Bytes( Str, Len ); }
+
+    private:
+        //Disable copy and assignment
+        SharedStringTable( const SharedStringTable & );
+        SharedStringTable & operator=( const SharedStringTable & );
+
+        struct Entry
+        {
+            const char *    Str;    ///< characters in the arena
+            uint32_t        Len;
+            uint32_t        Hash;
+        };
+
+        struct Fingerprint
+        {
+            uint64_t        Offset; ///< offset of the text in the verification file or ReadBack | offset in m_ReadBack
+            uint32_t        Len;
+            uint32_t        Hash;
+        };
+
+        struct WindowEntry
+        {
+            std::string     Text;   ///< the buffer is reused by the next string after the eviction
+            uint32_t        Hash;
+            uint32_t        Index;  ///< index of the string in the stream
+        };
+
+        static const uint32_t   FreeSlot = 0;
+        static const uint64_t   ReadBack = 0x8000000000000000ULL;
+        static const size_t     MinBlockSize = 64 * 1024;
+        static const size_t     MaxBlockSize = 1024 * 1024;
+        static const size_t     VerifyTailSize = 1024 * 1024;
+
+        uint64_t AddStored( const char * Str, size_t Len );
+        uint64_t AddStreamed( const char * Str, size_t Len );
+        uint64_t AddWindowed( const char * Str, size_t Len );
+        uint64_t WriteStreamed( const char * Str, size_t Len );
+        void RemoveWindowSlot( size_t Entry );
+        uint64_t Remember( const char * Str, size_t Len );
+        bool SameText( Fingerprint & F, const char * Str, size_t Len );
+        void Rehash( size_t SlotCount );
+        void RehashFingerprints( size_t SlotCount );
+        const char * Store( const char * Str, size_t Len );
+        char * AllocBlock( size_t Size );
+
+        std::vector<Entry>      m_Entries;      ///< strings in the order of their indices
+        std::vector<uint32_t>   m_Slots;        ///< entry (fingerprint) index + 1 or FreeSlot, the size is a power of 2
+        std::vector<char *>     m_Blocks;       ///< blocks of the arena
+        char        *           m_BlockPos;     ///< free space of the current block
+        size_t                  m_BlockLeft;
+        size_t                  m_BlockSize;    ///< size of the next block
+
+        bool                    m_Streamed;
+        XMLWriter       *       m_Stream;           ///< destination of the new strings in the streamed mode
+        size_t                  m_StreamedCount;
+        std::vector<Fingerprint> m_Fingerprints;    ///< streamed strings in the order of their indices
+        FILE            *       m_VerifyFile;       ///< texts of the streamed strings, NULL - all texts are in m_VerifyTail
+        std::vector<char>       m_VerifyTail;       ///< texts not written to m_VerifyFile yet
+        uint64_t                m_VerifyTailOffset; ///< offset of m_VerifyTail in the verification file
+        std::vector<char>       m_ReadBack;         ///< texts read back from m_VerifyFile
+
+        size_t                  m_Window;           ///< maximum number of the remembered strings, 0 - unbounded
+        std::vector<WindowEntry> m_WindowEntries;   ///< remembered strings
+        std::vector<uint8_t>    m_WindowReferenced; ///< CLOCK reference bits of m_WindowEntries
+        std::vector<uint32_t>   m_WindowSlots;      ///< m_WindowEntries index + 1 or FreeSlot, the size is a power of 2
+        size_t                  m_ClockHand;
+
+        uint64_t                m_Lookups;
+        uint64_t                m_Hits;
+        uint64_t                m_Evictions;
+};
+
+// ****************************************************************************
+/// @brief	HyperLogLog estimation of the number of the distinct strings (1 KiB, standard error about 3%)
+// ****************************************************************************
+class StringCardinality
+{
+    public:
+        StringCardinality() : m_Registers( RegisterCount, 0 ) {}
+
+        inline void Add( const char * Str, size_t Len )
+        {
+            const uint64_t Hash = SharedStringTable::Hash( Str, Len );
+            const size_t Register = static_cast<size_t>( Hash >> ( 64 - IndexBits ) );
+            uint64_t Rest = Hash << IndexBits;
+            uint8_t Rank = 1;   // position of the first 1 bit
+            for( ; ( Rank <= 64 - IndexBits ) && ( ( Rest & 0x8000000000000000ULL ) == 0 ); Rest <<= 1 )
+                Rank++;
+            if( Rank > m_Registers[ Register ] )
+                m_Registers[ Register ] = Rank;
+        }
+
+        uint64_t Estimate() const;
+
+    private:
+        static const size_t IndexBits = 10;
+        static const size_t RegisterCount = size_t( 1 ) << IndexBits;
+
+        std::vector<uint8_t>    m_Registers;
+};
+
+} // namespace SimpleXlsx
+
+#endif // XLSX_SHAREDSTRINGS_H
@@ -19,14 +19,75 @@
   3. This notice may not be removed or altered from any source distribution.
 */
 
+#include <cstring>
+
 #include "SimpleXlsxDef.h"
+#include "../ByteHash.hpp"
+
+// Helpers for the hashes of the style parts
+static inline uint64_t HashValue( uint64_t Hash, uint64_t Value )
+{
+    Hash ^= Value + 0x9E3779B97F4A7C15ULL + ( Hash << 6 ) + ( Hash >> 2 );
+    return Hash;
+}
+
+static inline uint64_t HashValue( uint64_t Hash, const std::string & Value )
+{
+    return HashValue( Hash, SimpleXlsx::ByteHash::Bytes( Value.data(), Value.size() ) );
+}
+
+static inline uint64_t HashValue( uint64_t Hash, SimpleXlsx::Color Value )
+{
+    return HashValue( Hash, Value.ARGB() );
+}
+
+static uint64_t HashValue( uint64_t Hash, const SimpleXlsx::Border::BorderItem & Item )
+{
+    return HashValue( HashValue( Hash, Item.style ), Item.color );
+}
+
+uint32_t SimpleXlsx::Color::Parse( const char * Str, size_t Len )
+{
+    if( ( Len == 7 ) && ( Str[ 0 ] == '#' ) )
+    {
+        Str++;
+        Len--;
+    }
+    if( ( Len != 6 ) && ( Len != 8 ) )
+        return 0;
+    uint32_t Value = 0;
+    for( size_t i = 0; i < Len; i++ )
+    {
+        const char Ch = Str[ i ];
+        uint32_t Digit;
+        if( ( Ch >= '0' ) && ( Ch <= '9' ) ) Digit = Ch - '0';
+        else if( ( Ch >= 'A' ) && ( Ch <= 'F' ) ) Digit = Ch - 'A' + 10;
+        else if( ( Ch >= 'a' ) && ( Ch <= 'f' ) ) Digit = Ch - 'a' + 10;
+        else return 0;
+        Value = ( Value << 4 ) | Digit;
+    }
+    return ( Len == 6 ) ? ( Value | 0xFF000000 ) : Value;
+}
+
+std::string SimpleXlsx::Color::ToString( bool Alpha ) const
+{
+    if( ! IsSet() )
+        return std::string();
+    static const char Hex[] = "0123456789ABCDEF";
+    char Buffer[ 8 ];
+    const size_t Len = Alpha ? 8 : 6;
+    uint32_t Value = m_argb;
+    for( size_t i = Len; i > 0; i--, Value >>= 4 )
+        Buffer[ i - 1 ] = Hex[ Value & 0x0F ];
+    return std::string( Buffer, Len );
+}
 
 void SimpleXlsx::Font::Clear()
 {
     size = 11;
     name = "Calibri";
     theme = true;
-    color = "";
+    color = Color();
     attributes = FONT_NORMAL;
 }
 
@@ -39,8 +100,8 @@ bool SimpleXlsx::Font::operator==( const SimpleXlsx::Font & _font ) const
 void SimpleXlsx::Fill::Clear()
 {
     patternType = PATTERN_NONE;
-    fgColor = "";
-    bgColor = "";
+    fgColor = Color();
+    bgColor = Color();
 }
 
 bool SimpleXlsx::Fill::operator==( const SimpleXlsx::Fill & _fill ) const
@@ -86,6 +147,86 @@ bool SimpleXlsx::NumFormat::operator==( const SimpleXlsx::NumFormat & _num ) con
              ( zeroColor == _num.zeroColor ) && ( showThousandsSeparator == _num.showThousandsSeparator ) );
 }
 
+SimpleXlsx::ConditionalRule SimpleXlsx::ConditionalRule::CellIs( ECondOperator op, const std::string & formula1, size_t dxfId,
+                                                                 const std::string & formula2 )
+{
+    ConditionalRule rule;
+    rule.type = CELL_IS;
+    rule.op = op;
+    rule.formula1 = formula1;
+    rule.formula2 = formula2;
+    rule.dxfId = dxfId;
+    return rule;
+}
+
+SimpleXlsx::ConditionalRule SimpleXlsx::ConditionalRule::Expression( const std::string & formula, size_t dxfId )
+{
+    ConditionalRule rule;
+    rule.type = EXPRESSION;
+    rule.formula1 = formula;
+    rule.dxfId = dxfId;
+    return rule;
+}
+
+SimpleXlsx::ConditionalRule SimpleXlsx::ConditionalRule::ColorScale( Color minColor, Color maxColor )
+{
+    ConditionalRule rule;
+    rule.type = COLOR_SCALE;
+    rule.thresholds.push_back( Threshold( COND_VALUE_MIN, "", minColor ) );
+    rule.thresholds.push_back( Threshold( COND_VALUE_MAX, "", maxColor ) );
+    return rule;
+}
+
+SimpleXlsx::ConditionalRule SimpleXlsx::ConditionalRule::ColorScale( Color minColor, Color midColor, Color maxColor )
+{
+    ConditionalRule rule = ColorScale( minColor, maxColor );
+    rule.thresholds.insert( rule.thresholds.begin() + 1, Threshold( COND_VALUE_PERCENTILE, "50", midColor ) );
+    return rule;
+}
+
+SimpleXlsx::ConditionalRule SimpleXlsx::ConditionalRule::DataBar( Color color )
+{
+    ConditionalRule rule;
+    rule.type = DATA_BAR;
+    rule.thresholds.push_back( Threshold( COND_VALUE_MIN ) );
+    rule.thresholds.push_back( Threshold( COND_VALUE_MAX ) );
+    rule.barColor = color;
+    return rule;
+}
+
+// ****************************************************************************
+/// @brief  Checks the rule before it is written: 2 or 3 thresholds of a color scale and 2 of a data bar,
+///         the colors are set, the numbers and formulae of the thresholds are not empty
+/// @return true if the rule can be written
+// ****************************************************************************
+bool SimpleXlsx::ConditionalRule::IsValid() const
+{
+    switch( type )
+    {
+        case CELL_IS:
+            if( ( op < COND_LESS ) || ( op > COND_NOT_BETWEEN ) ) return false;
+            if( ( ( op == COND_BETWEEN ) || ( op == COND_NOT_BETWEEN ) ) && formula2.empty() ) return false;
+            return ! formula1.empty();
+        case EXPRESSION:
+            return ! formula1.empty();
+        case COLOR_SCALE:
+            if( ( thresholds.size() < 2 ) || ( thresholds.size() > 3 ) ) return false;
+            break;
+        case DATA_BAR:
+            if( ( thresholds.size() != 2 ) || ! barColor.IsSet() ) return false;
+            break;
+        default:
+            return false;
+    }
+    for( std::vector<Threshold>::const_iterator it = thresholds.begin(); it != thresholds.end(); it++ )
+    {
+        if( ( it->type < COND_VALUE_MIN ) || ( it->type > COND_VALUE_FORMULA ) ) return false;
+        if( ( it->type != COND_VALUE_MIN ) && ( it->type != COND_VALUE_MAX ) && it->value.empty() ) return false;
+        if( ( type == COLOR_SCALE ) && ! it->color.IsSet() ) return false;
+    }
+    return true;
+}
+
 SimpleXlsx::Style::Style()
 {
     horizAlign = ALIGN_H_NONE;
@@ -128,36 +269,242 @@ char * SimpleXlsx::CellCoord::ToStringAbs( SimpleXlsx::CellCoord::TConvBuf & Buf
     return ToString< true >( Buffer );
 }
 
+const SimpleXlsx::CellCoord::ColumnName * SimpleXlsx::CellCoord::ColumnNames()
+{
+    class TTable
+    {
+        public:
+            ColumnName Names[ MaxCols ];
+
+            TTable()
+            {
+                std::memset( Names, 0, sizeof( Names ) );
+                for( uint32_t Col = 0; Col < MaxCols; Col++ )
+                {
+                    char Tmp[ 8 ];
+                    const size_t Len = Generate( Col, Tmp );
+                    std::memcpy( Names[ Col ].Name, Tmp, Len );
+                    Names[ Col ].Len = static_cast< uint8_t >( Len );
+                }
+            }
+    };
+    static const TTable Table;
+    return Table.Names;
+}
 
+size_t SimpleXlsx::CellCoord::ColumnToString( uint32_t Col, char * Buffer )
+{
+    if( Col >= MaxCols )
+        return Generate( Col, Buffer );
+    const ColumnName & Name = ColumnNames()[ Col ];
+    std::memcpy( Buffer, Name.Name, sizeof( Name.Name ) );
+    return Name.Len;
+}
 
-double SimpleXlsx::CellDataTime::From_time_t( time_t val )
+size_t SimpleXlsx::CellCoord::Generate( uint32_t Col, char * Buffer )
 {
-    const int64_t secondsFrom1900to1970 = 2208988800u;
-    const double excelOneSecond = 0.0000115740740740741;
-    struct tm * t = localtime( & val );
+    const uint32_t AlphLen = 26;
+    char Tmp[ 8 ];
+    char * StartPtr = Tmp + sizeof( Tmp );
+    uint64_t Val = uint64_t( Col ) + 1;
+    while( Val != 0 )
+    {
+        Val--;
+        * --StartPtr = static_cast< char >( 'A' + Val % AlphLen );
+        Val /= AlphLen;
+    }
+    const size_t Len = Tmp + sizeof( Tmp ) - StartPtr;
+    std::memcpy( Buffer, StartPtr, Len );
+    return Len;
+}
+
+
+
+// Transitions of the local time zone (e.g. to the daylight saving time) found for the periods of 2^25 seconds (388 days).
+// A period is probed once a day when it is used first time, so the offsets changed twice within one day are not found.
+class TimeZoneCache
+{
+    public:
+        inline int32_t Offset( int64_t Seconds )
+        {
+            const int64_t Period = ( Seconds >= 0 ? Seconds : Seconds - ( PeriodLength - 1 ) ) / PeriodLength;
+            if( m_periods.empty() )
+                Reset();
+            Entry & Item = m_periods[ static_cast<uint64_t>( Period ) & ( CacheSize - 1 ) ];
+            if( Item.period != Period )
+                Fill( Item, Period );
+            if( Item.count > MaxTransitions )
+                return LocalOffset( Seconds );
+            int32_t Result = Item.offset;
+            for( uint32_t i = 0; ( i < Item.count ) && ( Seconds >= Item.transitions[ i ] ); i++ )
+                Result = Item.offsets[ i ];
+            return Result;
+        }
+
+        inline void Reset()
+        {
+            Entry Empty;
+            std::memset( & Empty, 0, sizeof( Empty ) );
+            Empty.period = INT64_MIN;
+            m_periods.assign( CacheSize, Empty );
+        }
+
+    private:
+        static const int64_t PeriodLength = int64_t( 1 ) << 25;
+        static const size_t CacheSize = 256;        ///< periods in the cache (power of 2), 272 years
+        static const uint32_t MaxTransitions = 8;   ///< the periods with more transitions are not cached
+
+        struct Entry
+        {
+            int64_t period;
+            int32_t offset;                         ///< offset at the period begin
+            uint32_t count;                         ///< number of transitions (more than MaxTransitions - not cached)
+            int64_t transitions[ MaxTransitions ];  ///< first seconds of the new offsets
+            int32_t offsets[ MaxTransitions ];
+        };
+
+        static int32_t LocalOffset( int64_t Seconds )
+        {
+            const time_t Value = static_cast<time_t>( Seconds );
+            struct tm Local;
+#ifdef _WIN32
+            if( localtime_s( & Local, & Value ) != 0 )
+                return 0;
+#else
+            if( localtime_r( & Value, & Local ) == NULL )
+                return 0;
+#endif
+            const int64_t LocalSeconds = SimpleXlsx::ExcelCalendar::DaysFromCivil( Local.tm_year + 1900, Local.tm_mon + 1, Local.tm_mday ) * 86400 +
+                                         Local.tm_hour * 3600 + Local.tm_min * 60 + Local.tm_sec;
+            return static_cast<int32_t>( LocalSeconds - Seconds );
+        }
+
+        static void Fill( Entry & Item, int64_t Period )
+        {
+            const int64_t Begin = Period * PeriodLength, End = Begin + PeriodLength;
+            Item.period = Period;
+            Item.offset = LocalOffset( Begin );
+            Item.count = 0;
+            int32_t Current = Item.offset;
+            for( int64_t Lo = Begin; Lo < End; Lo += 86400 )
+            {
+                int64_t Hi = std::min( Lo + 86400, End ) - 1;
+                const int32_t Next = LocalOffset( Hi );
+                if( Next == Current )
+                    continue;
+                for( int64_t Low = Lo; Hi - Low > 1; )  //Offset at Low is Current, at Hi is Next
+                {
+                    const int64_t Mid = Low + ( Hi - Low ) / 2;
+                    ( LocalOffset( Mid ) == Current ? Low : Hi ) = Mid;
+                }
+                if( Item.count < MaxTransitions )
+                {
+                    Item.transitions[ Item.count ] = Hi;
+                    Item.offsets[ Item.count ] = Next;
+                }
+                Item.count++;
+                Current = Next;
+            }
+        }
+
+        std::vector<Entry> m_periods;
+};
+
+static thread_local TimeZoneCache LocalTimeZone;
 
-    time_t timeSinceEpoch = t->tm_sec + t->tm_min * 60 + t->tm_hour * 3600 + t->tm_yday * 86400 +
-                            ( t->tm_year - 70 ) * 31536000 + ( ( t->tm_year - 69 ) / 4 ) * 86400 -
-                            ( ( t->tm_year - 1 ) / 100 ) * 86400 + ( ( t->tm_year + 299 ) / 400 ) * 86400;
+static const size_t BatchSize = 256;    // Values converted between the lookups of the time zone offsets
 
-    return excelOneSecond * ( secondsFrom1900to1970 + timeSinceEpoch ) + 2;
+int32_t SimpleXlsx::ExcelCalendar::UTCOffset( time_t value )
+{
+    return LocalTimeZone.Offset( static_cast<int64_t>( value ) );
+}
+
+void SimpleXlsx::ExcelCalendar::ResetTimeZoneCache()
+{
+    LocalTimeZone.Reset();
+}
+
+void SimpleXlsx::ExcelCalendar::FillOffsets( const int64_t * seconds, size_t count, int64_t * offsets )
+{
+    TimeZoneCache & Cache = LocalTimeZone;
+    for( size_t i = 0; i < count; i++ )
+        offsets[ i ] = Cache.Offset( seconds[ i ] );
+}
+
+double SimpleXlsx::ExcelCalendar::FromTimeT( time_t value, bool localTime )
+{
+    const int64_t Seconds = static_cast<int64_t>( value ) + ( localTime ? UTCOffset( value ) : 0 );
+    return FromMilliseconds( ( Seconds + EpochDays * 86400 ) * 1000 );
+}
+
+double SimpleXlsx::ExcelCalendar::FromCivil( const Civil & value )
+{
+    const int64_t Seconds = ( DaysFromCivil( value.year, value.month, value.day ) + EpochDays ) * 86400 +
+                            value.hour * 3600 + value.minute * 60 + value.second;
+    const int64_t Milliseconds = Seconds * 1000 + value.millisecond;
+    if( ( value.year == 1900 ) && ( value.month == 2 ) && ( value.day == 29 ) )
+        return static_cast<double>( Milliseconds - DayMilliseconds ) / DayMilliseconds; //The serial 60 is placed before 1900-03-01
+    return FromMilliseconds( Milliseconds );
+}
+
+// The time zone offsets are found for a batch first, then the loop of the arithmetic can be vectorized
+void SimpleXlsx::ExcelCalendar::FromTimeT( const time_t * values, size_t count, double * serials, bool localTime )
+{
+    int64_t Seconds[ BatchSize ], Offsets[ BatchSize ] = { 0 };
+    for( size_t First = 0; First < count; First += BatchSize )
+    {
+        const size_t Count = std::min( BatchSize, count - First );
+        for( size_t i = 0; i < Count; i++ )
+            Seconds[ i ] = static_cast<int64_t>( values[ First + i ] );
+        if( localTime )
+            FillOffsets( Seconds, Count, Offsets );
+        for( size_t i = 0; i < Count; i++ )
+        {
+            const int64_t Milliseconds = ( Seconds[ i ] + Offsets[ i ] + EpochDays * 86400 ) * 1000;
+            serials[ First + i ] = static_cast<double>( Milliseconds - ( Milliseconds < 61 * DayMilliseconds ? DayMilliseconds : 0 ) ) / DayMilliseconds;
+        }
+    }
+}
+
+void SimpleXlsx::ExcelCalendar::FromEpochMilliseconds( const int64_t * values, size_t count, double * serials, bool localTime )
+{
+    int64_t Seconds[ BatchSize ], Offsets[ BatchSize ] = { 0 };
+    for( size_t First = 0; First < count; First += BatchSize )
+    {
+        const size_t Count = std::min( BatchSize, count - First );
+        if( localTime )
+        {
+            for( size_t i = 0; i < Count; i++ )
+            {
+                const int64_t Value = values[ First + i ];
+                Seconds[ i ] = ( Value >= 0 ? Value : Value - 999 ) / 1000;
+            }
+            FillOffsets( Seconds, Count, Offsets );
+        }
+        for( size_t i = 0; i < Count; i++ )
+        {
+            const int64_t Milliseconds = values[ First + i ] + ( Offsets[ i ] + EpochDays * 86400 ) * 1000;
+            serials[ First + i ] = static_cast<double>( Milliseconds - ( Milliseconds < 61 * DayMilliseconds ? DayMilliseconds : 0 ) ) / DayMilliseconds;
+        }
+    }
+}
+
+void SimpleXlsx::ExcelCalendar::FromCivil( const Civil * values, size_t count, double * serials )
+{
+    for( size_t i = 0; i < count; i++ )
+        serials[ i ] = FromCivil( values[ i ] );
 }
 
 double SimpleXlsx::CellDataTime::FromGregorian( uint16_t year, uint16_t month, uint16_t day, uint16_t hour, uint16_t minute, uint16_t second, uint16_t millisecond )
 {
-    const bool IsLeapYear = ( ( year & 0x0003 ) == 0 ) && ( year % 400 != 0 );
-    const uint8_t DM[ 12 ] = { 31, uint8_t( IsLeapYear ? 29 : 28 ), 31, 30, 31, 30, 31, 31, 30, 31, 30, 31  };
-    const double excelOneSecond = 0.0000115740740740741;
+    // Excel has the day 1900-02-29
+    const uint8_t DM[ 12 ] = { 31, uint8_t( ( ExcelCalendar::IsLeapYear( year ) || ( year == 1900 ) ) ? 29 : 28 ), 31, 30, 31, 30, 31, 31, 30, 31, 30, 31  };
     assert( ( year >= 1900 ) && ( year < 10000 ) ); // Excel restrictions
     assert( ( month >= 1 ) && ( month <= 12 ) && ( day >= 1 ) && ( day <= DM[ month - 1 ] ) );
     assert( ( hour <= 23 ) && ( minute <= 59 ) && ( second <= 59 ) && ( millisecond <= 999 ) );
-    int PrevMonthDays = 0;
-    for( int i = 0; i < month - 1; ++i )
-        PrevMonthDays += DM[ i ];
-    const int64_t YearsSince1900 = year - 1900;
-    const int64_t LeapYears = ( YearsSince1900 - 1 ) / 4 + ( YearsSince1900 != 0 ? 1 : 0 );
-    double TotalSeconds = second + minute * 60 + hour * 3600 + YearsSince1900 * 31536000 + ( PrevMonthDays + day - 1 + LeapYears ) * 86400;
-    return excelOneSecond * ( TotalSeconds + millisecond / 1000.0 ) + 1.0;  // + 1.0 for 1900.01.01
+    ( void )DM;
+    const ExcelCalendar::Civil Value = { year, uint8_t( month ), uint8_t( day ), uint8_t( hour ), uint8_t( minute ), uint8_t( second ), millisecond };
+    return ExcelCalendar::FromCivil( Value );
 }
 
 void SimpleXlsx::Comment::Clear()
@@ -171,6 +518,31 @@ void SimpleXlsx::Comment::Clear()
 }
 
 
+const size_t SimpleXlsx::ItemHashIndex::NoItem;
+const uint32_t SimpleXlsx::ItemHashIndex::FreeSlot;
+
+void SimpleXlsx::ItemHashIndex::Add( uint64_t Hash )
+{
+    assert( m_Hashes.size() < 0xFFFFFFFF );
+    m_Hashes.push_back( Hash );
+    if( m_Hashes.size() * 10 > m_Slots.size() * 7 )     // load factor up to 0.7
+    {
+        m_Slots.assign( m_Slots.size() * 2, FreeSlot );
+        for( size_t i = 0; i < m_Hashes.size(); i++ )
+            Insert( i );
+    }
+    else Insert( m_Hashes.size() - 1 );
+}
+
+void SimpleXlsx::ItemHashIndex::Insert( size_t Item )
+{
+    const size_t Mask = m_Slots.size() - 1;
+    size_t Pos = static_cast<size_t>( m_Hashes[ Item ] ) & Mask;
+    while( m_Slots[ Pos ] != FreeSlot )
+        Pos = ( Pos + 1 ) & Mask;
+    m_Slots[ Pos ] = static_cast<uint32_t>( Item + 1 );
+}
+
 SimpleXlsx::StyleList::StyleList()
 {
     m_fmtLastId = BUILT_IN_STYLES_NUMBER;
@@ -185,112 +557,86 @@ SimpleXlsx::StyleList::StyleList()
 
 size_t SimpleXlsx::StyleList::Add( const SimpleXlsx::Style & style )
 {
-    std::vector<size_t> styleLinks( STYLE_LINK_NUMBER );
-
-    // Check border existance
-    bool addItem = true;
-    for( size_t i = 0; i < m_borders.size(); i++ )
-    {
-        if( m_borders[i] == style.border )
-        {
-            addItem = false;
-            styleLinks[STYLE_LINK_BORDER] = i;
-            break;
-        }
-    }
-
-    // Add border if it is not in collection yet
-    if( addItem )
-    {
-        m_borders.push_back( style.border );
-        styleLinks[STYLE_LINK_BORDER] = m_borders.size() - 1;
-    }
-
-    // Check font existance
-    addItem = true;
-    for( size_t i = 0; i < m_fonts.size(); i++ )
-    {
-        if( m_fonts[i] == style.font )
-        {
-            addItem = false;
-            styleLinks[STYLE_LINK_FONT] = i;
-            break;
-        }
-    }
-
-    // Add font if it is not in collection yet
-    if( addItem )
+    StyleLinks styleLinks;
+
+    // Find border or add it if it is not in collection yet
+    const Border & border = style.border;
+    uint64_t hash = HashValue( HashValue( 0, border.isDiagonalUp ), border.isDiagonalDown );
+    hash = HashValue( HashValue( HashValue( HashValue( hash, border.left ), border.right ), border.bottom ), border.top );
+    size_t item = m_borderIndex.Find( hash, [ & ]( size_t i ) { return m_borders[ i ] == border; } );
+    if( item == ItemHashIndex::NoItem )
     {
-        m_fonts.push_back( style.font );
-        styleLinks[STYLE_LINK_FONT] = m_fonts.size() - 1;
+        item = m_borders.size();
+        m_borders.push_back( border );
+        m_borderIndex.Add( hash );
     }
-
-    // Check fill existance
-    addItem = true;
-    for( size_t i = 0; i < m_fills.size(); i++ )
-    {
-        if( m_fills[i] == style.fill )
-        {
-            addItem = false;
-            styleLinks[STYLE_LINK_FILL] = i;
-            break;
-        }
-    }
-
-    // Add fill if it is not in collection yet
-    if( addItem )
+    styleLinks.link[ STYLE_LINK_BORDER ] = item;
+
+    // Find font or add it if it is not in collection yet
+    const Font & font = style.font;
+    hash = HashValue( HashValue( HashValue( 0, font.name.toStdString() ), font.color ), font.size );
+    hash = HashValue( HashValue( hash, font.attributes ), font.theme );
+    item = m_fontIndex.Find( hash, [ & ]( size_t i ) { return m_fonts[ i ] == font; } );
+    if( item == ItemHashIndex::NoItem )
     {
-        m_fills.push_back( style.fill );
-        styleLinks[STYLE_LINK_FILL] = m_fills.size() - 1;
+        item = m_fonts.size();
+        m_fonts.push_back( font );
+        m_fontIndex.Add( hash );
     }
+    styleLinks.link[ STYLE_LINK_FONT ] = item;
 
-    // Check number format existance
-    addItem = true;
-    for( size_t i = 0; i < m_nums.size(); i++ )
+    // Find fill or add it if it is not in collection yet
+    const Fill & fill = style.fill;
+    hash = HashValue( HashValue( HashValue( 0, fill.patternType ), fill.fgColor ), fill.bgColor );
+    item = m_fillIndex.Find( hash, [ & ]( size_t i ) { return m_fills[ i ] == fill; } );
+    if( item == ItemHashIndex::NoItem )
     {
-        if( m_nums[i] == style.numFormat )
-        {
-            addItem = false;
-            styleLinks[STYLE_LINK_NUM_FORMAT] = m_nums[ i ].id;
-            break;
-        }
+        item = m_fills.size();
+        m_fills.push_back( fill );
+        m_fillIndex.Add( hash );
     }
-
-    // Add number format if it is not in collection yet
-    if( addItem )
+    styleLinks.link[ STYLE_LINK_FILL ] = item;
+
+    // Find number format or add it if it is not in collection yet
+    const NumFormat & num = style.numFormat;
+    hash = HashValue( HashValue( HashValue( 0, num.formatString ), num.numberStyle ), num.numberOfDigitsAfterPoint );
+    hash = HashValue( HashValue( HashValue( HashValue( hash, num.positiveColor ), num.negativeColor ), num.zeroColor ), num.showThousandsSeparator );
+    item = m_numIndex.Find( hash, [ & ]( size_t i ) { return m_nums[ i ] == num; } );
+    if( item != ItemHashIndex::NoItem )
+        styleLinks.link[ STYLE_LINK_NUM_FORMAT ] = m_nums[ item ].id;
+    else
     {
-        if( style.numFormat.id >= BUILT_IN_STYLES_NUMBER )
+        if( num.id >= BUILT_IN_STYLES_NUMBER )
         {
-            styleLinks[STYLE_LINK_NUM_FORMAT] = m_fmtLastId;
-            style.numFormat.id = m_fmtLastId++;
+            styleLinks.link[ STYLE_LINK_NUM_FORMAT ] = m_fmtLastId;
+            num.id = m_fmtLastId++;
         }
         else
         {
-            styleLinks[STYLE_LINK_NUM_FORMAT] = m_nums.size();
+            styleLinks.link[ STYLE_LINK_NUM_FORMAT ] = m_nums.size();
         }
 
-        m_nums.push_back( style.numFormat );
-    }
-
-    // Check style combination existance
-    for( size_t i = 0; i < m_styleIndexes.size(); i++ )
-    {
-        if( ( m_styleIndexes[i] == styleLinks ) &&
-                ( m_stylePos[i].horizAlign == style.horizAlign ) &&
-                ( m_stylePos[i].vertAlign == style.vertAlign ) &&
-                ( m_stylePos[i].wrapText == style.wrapText ) &&
-                ( m_stylePos[i].textRotation == style.textRotation ) )
-            return i;
+        m_nums.push_back( num );
+        m_numIndex.Add( hash );
     }
 
+    // Find style combination or add it if it is not in collection yet
     StylePosInfo pos;
     pos.horizAlign = style.horizAlign;
     pos.vertAlign = style.vertAlign;
     pos.wrapText = style.wrapText;
     pos.textRotation = style.textRotation;
-    m_stylePos.push_back( pos );
+    hash = 0;
+    for( size_t i = 0; i < STYLE_LINK_NUMBER; i++ )
+        hash = HashValue( hash, styleLinks[ i ] );
+    hash = HashValue( HashValue( HashValue( HashValue( hash, pos.horizAlign ), pos.vertAlign ), pos.wrapText ), pos.textRotation );
+    item = m_styleIndex.Find( hash, [ & ]( size_t i ) { return ( m_styleIndexes[ i ] == styleLinks ) && ( m_stylePos[ i ] == pos ); } );
+    if( item != ItemHashIndex::NoItem )
+        return item;
 
+    m_stylePos.push_back( pos );
     m_styleIndexes.push_back( styleLinks );
+    m_styleIndex.Add( hash );
     return m_styleIndexes.size() - 1;
 }
 
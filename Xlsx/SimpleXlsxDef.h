@@ -23,16 +23,24 @@
 #define XLSX_SIMPLE_XLSX_DEF_H
 
 #include <stdint.h>
+#include <algorithm>
 #include <cassert>
+#include <cstring>
 #include <ctime>
 #include <fstream>
 #include <list>
 #include <map>
+#include <memory>
 #include <sstream>
 #include <string>
 #include <vector>
 #include <utility>
 
+#if ( __cplusplus >= 201703L ) || ( defined( _MSVC_LANG ) && ( _MSVC_LANG >= 201703L ) )
+#include <string_view>
+#define SIMPLE_XLSX_STRING_VIEW
+#endif
+
 #ifdef _WIN32
 #include <windows.h>
 #endif
@@ -41,6 +49,7 @@
 #include <QDateTime>
 #endif
 
+#include "../NumberToChars.hpp"
 #include "../UTF8Encoder.hpp"
 
 #define SIMPLE_XLSX_VERSION	"0.41"
@@ -48,70 +57,79 @@
 namespace SimpleXlsx
 {
 // Helper class for simultaneous work with std::string and std::wstring
+// The text is stored once in UTF-8, std::wstring is decoded on the first request and cached
+// (the cache is not thread-safe: do not request std::wstring of the same object from different threads)
 class UniString
 {
     public:
         UniString() {}
 
-        UniString( const char * Str ) : m_string( Str ), m_wstring( m_string.begin(), m_string.end() ) {}
-        UniString( const std::string & Str ) : m_string( Str ), m_wstring( m_string.begin(), m_string.end() ) {}
+        UniString( const char * Str ) : m_string( Str ) {}
+        UniString( const std::string & Str ) : m_string( Str ) {}
 
-        UniString( const wchar_t * Str ) : m_wstring( Str )
-        {
-            m_string = UTF8Encoder::From_wstring( m_wstring );
-        }
-        UniString( const std::wstring & Str ) : m_wstring( Str )
-        {
-            m_string = UTF8Encoder::From_wstring( m_wstring );
-        }
+        UniString( const wchar_t * Str ) : m_string( UTF8Encoder::From_wstring( Str ) ) {}
+        UniString( const std::wstring & Str ) : m_string( UTF8Encoder::From_wstring( Str ) ) {}
+
+        UniString( const UniString & other ) : m_string( other.m_string ) {}
 
         // *INDENT-OFF*   For AStyle tool
         inline bool empty() const   {   return m_string.empty();    }
 
-        inline operator const std::string & () const    {   return m_string;    }
-        inline operator const std::wstring & () const   {   return m_wstring;   }
+        inline operator const std::string & () const    {   return m_string;        }
+        inline operator const std::wstring & () const   {   return toStdWString();  }
 
-        inline const std::string & toStdString() const      {   return m_string;    }
-        inline const std::wstring & toStdWString() const    {   return m_wstring;   }
+        inline const std::string & toStdString() const  {   return m_string;    }
 
         inline bool operator==( const std::string & other ) const   {   return m_string == other;   }
         inline bool operator!=( const std::string & other ) const   {   return !( *this == other ); }
-        inline bool operator==( const std::wstring & other ) const  {   return m_wstring == other;  }
+        inline bool operator==( const std::wstring & other ) const  {   return m_string == UTF8Encoder::From_wstring( other );  }
         inline bool operator!=( const std::wstring & other ) const  {   return !( *this == other ); }
         inline bool operator==( const UniString & other ) const     {   return *this == other.m_string; }
         inline bool operator!=( const UniString & other ) const     {   return !( *this == other ); }
         // *INDENT-ON*   For AStyle tool
 
-        UniString & operator=( const char * other )
+        inline const std::wstring & toStdWString() const
+        {
+            if( m_wstring.get() == NULL )
+                m_wstring.reset( new std::wstring( UTF8Encoder::To_wstring( m_string ) ) );
+            return * m_wstring;
+        }
+
+        UniString & operator=( const UniString & other )
         {
-            m_string = other;
-            m_wstring = std::wstring( m_string.begin(), m_string.end() );
+            if( this != & other )
+                Assign( other.m_string );
             return * this;
         }
+        UniString & operator=( const char * other )
+        {
+            return Assign( other );
+        }
         UniString & operator=( const std::string & other )
         {
-            m_string = other;
-            m_wstring = std::wstring( m_string.begin(), m_string.end() );
-            return * this;
+            return Assign( other );
         }
         UniString & operator=( const wchar_t * other )
         {
-            m_wstring = other;
-            m_string = UTF8Encoder::From_wstring( other );
-            return * this;
+            return Assign( UTF8Encoder::From_wstring( other ) );
         }
         UniString & operator=( const std::wstring & other )
         {
-            m_wstring = other;
-            m_string = UTF8Encoder::From_wstring( other );
-            return * this;
+            return Assign( UTF8Encoder::From_wstring( other ) );
         }
 
         friend std::ostream & operator<<( std::ostream & os, const UniString & str );
 
     private:
-        std::string     m_string;
-        std::wstring    m_wstring;
+        inline UniString & Assign( const std::string & Str )
+        {
+            m_string = Str;
+            m_wstring.reset();
+            return * this;
+        }
+
+        std::string                             m_string;
+        mutable std::unique_ptr<std::wstring>   m_wstring;  ///< decoded m_string, created by toStdWString
 };
 
 inline std::ostream & operator<<( std::ostream & os, const UniString & str )
@@ -205,6 +223,39 @@ enum EAlignVert
     ALIGN_V_BOTTOM
 };
 
+/// @brief	Comparison operators of the conditional formatting rules (cellIs)
+enum ECondOperator
+{
+    COND_LESS = 0,
+    COND_LESS_EQUAL,
+    COND_EQUAL,
+    COND_NOT_EQUAL,
+    COND_GREATER_EQUAL,
+    COND_GREATER,
+    COND_BETWEEN,
+    COND_NOT_BETWEEN
+};
+
+/// @brief	Kinds of the thresholds of the color scales and the data bars
+enum ECondValueType
+{
+    COND_VALUE_MIN = 0,
+    COND_VALUE_MAX,
+    COND_VALUE_NUMBER,
+    COND_VALUE_PERCENT,
+    COND_VALUE_PERCENTILE,
+    COND_VALUE_FORMULA
+};
+
+/// @brief	Storage of the cell strings
+enum EStringMode
+{
+    STRINGS_DEFAULT = 0,    ///< the mode of the column, else the mode of the sheet (shared by default)
+    STRINGS_SHARED,         ///< the index of the string in xl/sharedStrings.xml
+    STRINGS_INLINE,         ///< the string in the cell (t="inlineStr"), not kept by the workbook
+    STRINGS_AUTO            ///< shared or inline, chosen per column by the estimated share of the distinct strings
+};
+
 /// @brief	Number styling most general enumeration
 enum ENumericStyle
 {
@@ -233,13 +284,46 @@ enum ENumericStyleColor
     NUMSTYLE_COLOR_RED
 };
 
+/// @brief  Packed 32-bit ARGB color
+/// @note   Strings "AARRGGBB", "RRGGBB" and "#RRGGBB" (opaque) are accepted for compatibility.
+///         The empty or malformed string and the value 0 mean that the color is not set.
+class Color
+{
+    public:
+        // *INDENT-OFF*   For AStyle tool
+        constexpr Color() : m_argb( 0 ) {}
+        constexpr explicit Color( uint32_t argb ) : m_argb( argb ) {}
+        inline Color( const char * hex ) : m_argb( Parse( hex, ( hex == NULL ) ? 0 : std::strlen( hex ) ) ) {}
+        inline Color( const std::string & hex ) : m_argb( Parse( hex.data(), hex.size() ) ) {}
+
+        static constexpr Color FromRGB( uint8_t r, uint8_t g, uint8_t b, uint8_t a = 0xFF )
+        { return Color( ( uint32_t( a ) << 24 ) | ( uint32_t( r ) << 16 ) | ( uint32_t( g ) << 8 ) | b ); }
+
+        constexpr bool      IsSet() const   { return m_argb != 0; }
+        constexpr bool      empty() const   { return m_argb == 0; }
+        constexpr uint32_t  ARGB() const    { return m_argb; }
+        constexpr uint32_t  RGB() const     { return m_argb & 0xFFFFFF; }
+
+        constexpr bool operator==( const Color & other ) const  { return m_argb == other.m_argb; }
+        constexpr bool operator!=( const Color & other ) const  { return m_argb != other.m_argb; }
+        // *INDENT-ON*   For AStyle tool
+
+        /// @brief  Returns "AARRGGBB" (with Alpha) or "RRGGBB", or the empty string if the color is not set
+        std::string ToString( bool Alpha = true ) const;
+
+    private:
+        static uint32_t Parse( const char * Str, size_t Len );
+
+        uint32_t m_argb;
+};
+
 /// @brief  Font describes a font that can be added into final document stylesheet
 /// @see    EFontAttributes
 class Font
 {
     public:
         UniString name;		///< font name (there is no enumeration or preset values, it should be used carefully)
-        std::string color;	///< color format: AARRGGBB - (alpha, red, green, blue). If empty default theme is used
+        Color color;		///< color format: AARRGGBB - (alpha, red, green, blue). If not set default theme is used
         int32_t size;		///< font size
         int32_t attributes;	///< combination of additinal font flags (EFontAttributes)
         bool theme;			///< theme if true then color is not taken into account
@@ -262,11 +346,11 @@ class Fill
 {
     public:
         EPatternType patternType;	///< patternType
-        std::string fgColor;		///< fgColor foreground color format: AARRGGBB - (alpha, red, green, blue). Can be left unset
-        std::string bgColor;		///< bgColor background color format: AARRGGBB - (alpha, red, green, blue). Can be left unset
+        Color fgColor;				///< fgColor foreground color format: AARRGGBB - (alpha, red, green, blue). Can be left unset
+        Color bgColor;				///< bgColor background color format: AARRGGBB - (alpha, red, green, blue). Can be left unset
 
     public:
-        Fill() : patternType( PATTERN_NONE ), fgColor( "" ), bgColor( "" ) {}
+        Fill() : patternType( PATTERN_NONE ) {}
 
         void Clear();
 
@@ -282,14 +366,14 @@ class Border
         struct BorderItem
         {
             EBorderStyle style;		///< style border style
-            std::string color;		///< colour border colour format: AARRGGBB - (alpha, red, green, blue). Can be left unset
+            Color color;			///< colour border colour format: AARRGGBB - (alpha, red, green, blue). Can be left unset
 
-            BorderItem() : style( BORDER_NONE ), color( "" ) {}
+            BorderItem() : style( BORDER_NONE ) {}
 
             void Clear()
             {
                 style = BORDER_NONE;
-                color = "";
+                color = Color();
             }
 
             bool operator==( const BorderItem & _borderItem ) const
@@ -347,12 +431,17 @@ class NumFormat
 /// @brief	Cell coordinate structure
 class CellCoord
 {
-        static const uint8_t ColStrOffset = 11;
-
     public:
         static const uint8_t ConvBufSize = 24;
         typedef char TConvBuf[ ConvBufSize ];   // Max string for $Col$Row\0
 
+        /// @brief  Item of the precomputed table of column names
+        struct ColumnName
+        {
+            char    Name[ 3 ];  ///< "A".."XFD", not null-terminated
+            uint8_t Len;        ///< number of used characters in Name
+        };
+
         static const uint32_t   MinRow = 1, MinCol = 0;
         static const uint32_t   MaxRows = 1048576, MaxCols = 16384; // Excel limits
         uint32_t row;	///< row (starts from 1)
@@ -374,6 +463,11 @@ class CellCoord
         std::string ToStringAbs() const;
         char * ToStringAbs( TConvBuf & Buffer ) const;
 
+        // Returns the table of names for all MaxCols columns, built once at the first call
+        static const ColumnName * ColumnNames();
+        // Writes the column name (without '\0') and returns the number of characters
+        static size_t ColumnToString( uint32_t Col, char * Buffer );
+
         inline bool operator==( const CellCoord & other ) const
         {
             return ( row == other.row ) && ( col == other.col );
@@ -384,30 +478,20 @@ class CellCoord
         }
 
     private:
+        static size_t Generate( uint32_t Col, char * Buffer );
+
         template< bool AbsColAndRow >
         inline char * ToString( char * Buffer ) const
         {
-            const int32_t iAlphLen = 26;
-            const char * szAlph = "ABCDEFGHIJKLMNOPQRSTUVWXYZ";
-
-            Buffer[ CellCoord::ColStrOffset ] = szAlph[ col % iAlphLen ];
-            char * StartPtr = Buffer + CellCoord::ColStrOffset;
-            int32_t div = col / iAlphLen;
-            while( div != 0 )
-            {
-                div--;
-                StartPtr--;
-                * StartPtr = szAlph[ div % iAlphLen ];
-                div /= iAlphLen;
-            }
+            char * Ptr = Buffer;
             if( AbsColAndRow )
-            {
-                StartPtr--;
-                * StartPtr = '$';
-                Buffer[ CellCoord::ColStrOffset + 1 ] = '$';
-            }
-            sprintf( Buffer + CellCoord::ColStrOffset + ( AbsColAndRow ? 2 : 1 ), "%u", row );
-            return StartPtr;
+                * Ptr++ = '$';
+            Ptr += ColumnToString( col, Ptr );
+            if( AbsColAndRow )
+                * Ptr++ = '$';
+            Ptr += NumberToChars::UInt( row, Ptr );
+            * Ptr = '\0';
+            return Buffer;
         }
 };
 
@@ -435,13 +519,10 @@ class CellDataStr
         CellDataStr( const char * pStr ) : value( pStr ), style_id( 0 ) {}
         CellDataStr( const std::string & _str ) : value( _str ), style_id( 0 ) {}
         CellDataStr( const std::string & _str, size_t _style_id ) : value( _str ), style_id( _style_id ) {}
-
-        CellDataStr & operator=( const CellDataStr & obj )
-        {
-            value = obj.value;
-            style_id = obj.style_id;
-            return *this;
-        }
+        CellDataStr( std::string && _str, size_t _style_id = 0 ) : value( std::move( _str ) ), style_id( _style_id ) {}
+#ifdef SIMPLE_XLSX_STRING_VIEW
+        CellDataStr( std::string_view _str, size_t _style_id = 0 ) : value( _str ), style_id( _style_id ) {}
+#endif
 
         CellDataStr & operator=( const char * pStr )
         {
@@ -455,6 +536,12 @@ class CellDataStr
             return *this;
         }
 
+        CellDataStr & operator=( std::string && _str )
+        {
+            value = std::move( _str );
+            return *this;
+        }
+
         CellDataStr( const std::wstring & _str ) : value( UTF8Encoder::From_wstring( _str ) ), style_id( 0 ) {}
         CellDataStr( const std::wstring & _str, size_t _style_id ) : value( UTF8Encoder::From_wstring( _str ) ), style_id( _style_id ) {}
 
@@ -471,6 +558,59 @@ class CellDataStr
         }
 };	///< cell data:style pair
 
+/// @brief  Conversion of dates and times to the serial numbers of Excel (days since 1899-12-30 with the time as the fraction)
+/// @note   Excel counts the nonexistent day 1900-02-29 (serial 60), so the serials of the earlier dates are less by one day.
+///         The offsets of the local time zone are cached per day by every thread, call ResetTimeZoneCache after tzset().
+class ExcelCalendar
+{
+    public:
+        struct Civil
+        {
+            uint16_t year;
+            uint8_t month, day, hour, minute, second;
+            uint16_t millisecond;
+        };
+
+        static const int64_t EpochDays = 25569;     ///< days from 1899-12-30 to 1970-01-01
+        static const int64_t DayMilliseconds = 86400000;
+
+        // Days since 1970-01-01 of the proleptic Gregorian date (month from 1, day from 1)
+        static inline int64_t DaysFromCivil( int64_t year, uint32_t month, uint32_t day )
+        {
+            year -= ( month <= 2 ) ? 1 : 0;
+            const int64_t Era = ( year >= 0 ? year : year - 399 ) / 400;
+            const int64_t YearOfEra = year - Era * 400;
+            const int64_t DayOfYear = ( 153 * ( month > 2 ? month - 3 : month + 9 ) + 2 ) / 5 + day - 1;
+            return Era * 146097 + YearOfEra * 365 + YearOfEra / 4 - YearOfEra / 100 + DayOfYear - 719468;
+        }
+
+        static inline bool IsLeapYear( int64_t year )
+        {
+            return ( year % 4 == 0 ) && ( ( year % 100 != 0 ) || ( year % 400 == 0 ) );
+        }
+
+        // Serial of the time given in milliseconds since 1899-12-30 00:00 (rounded once)
+        static inline double FromMilliseconds( int64_t msSince1899 )
+        {
+            return static_cast<double>( msSince1899 - ( msSince1899 < 61 * DayMilliseconds ? DayMilliseconds : 0 ) ) / DayMilliseconds;
+        }
+
+        // Offset of the local time from UTC in seconds
+        static int32_t UTCOffset( time_t value );
+        static void ResetTimeZoneCache();
+
+        static double FromTimeT( time_t value, bool localTime = true );
+        static double FromCivil( const Civil & value );
+
+        // Batch conversions, the arrays of values and serials have count items
+        static void FromTimeT( const time_t * values, size_t count, double * serials, bool localTime = true );
+        static void FromEpochMilliseconds( const int64_t * values, size_t count, double * serials, bool localTime = true );
+        static void FromCivil( const Civil * values, size_t count, double * serials );
+
+    private:
+        static void FillOffsets( const int64_t * seconds, size_t count, int64_t * offsets );
+};
+
 class CellDataTime
 {
     public:
@@ -545,7 +685,10 @@ class CellDataTime
     private:
         double m_xlsx_val;
 
-        static double From_time_t( time_t val );
+        static inline double From_time_t( time_t val )
+        {
+            return ExcelCalendar::FromTimeT( val );
+        }
         // Year must be in the range 1900 to 9999, month must be in the range 1 to 12, and day must be in the range 1 to 31.
         // Hour must be in the range 0 to 23, minute and second must be in the range 0 to 59, and millisecond must be in the range 0 to 999.
         static double FromGregorian( uint16_t year, uint16_t month, uint16_t day, uint16_t hour, uint16_t minute, uint16_t second, uint16_t millisecond = 0 );
@@ -675,6 +818,58 @@ class CellDataFlt
         }
 };	///< cell data:style pair
 
+/// @brief	Column of values for CWorksheet::AddColumns. The values are not copied,
+///         the array must contain at least the number of the added rows.
+class ColumnData
+{
+    public:
+        enum EType
+        {
+            TYPE_EMPTY = 0, ///< no cells in the column
+            TYPE_INT32,
+            TYPE_UINT32,
+            TYPE_INT64,
+            TYPE_UINT64,
+            TYPE_FLOAT,
+            TYPE_DOUBLE,
+            TYPE_TIME,      ///< time_t values
+            TYPE_TIME_MS,   ///< int64_t milliseconds since 1970-01-01 00:00 UTC
+            TYPE_CSTR,      ///< const char * values (NULL or empty - no cell)
+            TYPE_STRING     ///< std::string values (empty - no cell)
+        };
+
+        EType           type;
+        const void   *  values;
+        size_t          style_id;
+
+    public:
+        ColumnData() : type( TYPE_EMPTY ), values( NULL ), style_id( 0 ) {}
+        ColumnData( const int32_t * _values, size_t _style_id = 0 ) : type( TYPE_INT32 ), values( _values ), style_id( _style_id ) {}
+        ColumnData( const uint32_t * _values, size_t _style_id = 0 ) : type( TYPE_UINT32 ), values( _values ), style_id( _style_id ) {}
+        ColumnData( const int64_t * _values, size_t _style_id = 0 ) : type( TYPE_INT64 ), values( _values ), style_id( _style_id ) {}
+        ColumnData( const uint64_t * _values, size_t _style_id = 0 ) : type( TYPE_UINT64 ), values( _values ), style_id( _style_id ) {}
+        ColumnData( const float * _values, size_t _style_id = 0 ) : type( TYPE_FLOAT ), values( _values ), style_id( _style_id ) {}
+        ColumnData( const double * _values, size_t _style_id = 0 ) : type( TYPE_DOUBLE ), values( _values ), style_id( _style_id ) {}
+        ColumnData( const char * const * _values, size_t _style_id = 0 ) : type( TYPE_CSTR ), values( _values ), style_id( _style_id ) {}
+        ColumnData( const std::string * _values, size_t _style_id = 0 ) : type( TYPE_STRING ), values( _values ), style_id( _style_id ) {}
+
+        // time_t may be the same type as one of the integer types, so it has a separate function
+        static inline ColumnData Time( const time_t * _values, size_t _style_id = 0 )
+        {
+            ColumnData Result;
+            Result.type = TYPE_TIME;
+            Result.values = _values;
+            Result.style_id = _style_id;
+            return Result;
+        }
+        static inline ColumnData TimeMilliseconds( const int64_t * _values, size_t _style_id = 0 )
+        {
+            ColumnData Result( _values, _style_id );
+            Result.type = TYPE_TIME_MS;
+            return Result;
+        }
+};
+
 /// @brief	This structure describes comment item that can added to a cell
 struct Comment
 {
@@ -726,7 +921,42 @@ struct Style
     void Clear();
 };
 
+/// @brief  Open-addressing index of the items stored in a vector by their hashes (used by StyleList)
+class ItemHashIndex
+{
+    public:
+        static const size_t NoItem = ~size_t( 0 );
+
+        ItemHashIndex() : m_Slots( 16, FreeSlot ) {}
+
+        /// @brief  Returns the position of the item with the Hash for which Equal( position ) is true, or NoItem
+        template<typename TEqual>
+        size_t Find( uint64_t Hash, TEqual Equal ) const
+        {
+            const size_t Mask = m_Slots.size() - 1;
+            for( size_t Pos = static_cast<size_t>( Hash ) & Mask; m_Slots[ Pos ] != FreeSlot; Pos = ( Pos + 1 ) & Mask )
+            {
+                const size_t Item = m_Slots[ Pos ] - 1;
+                if( ( m_Hashes[ Item ] == Hash ) && Equal( Item ) )
+                    return Item;
+            }
+            return NoItem;
+        }
+
+        /// @brief  Adds the hash of the next item (the position is the number of the added items)
+        void Add( uint64_t Hash );
+
+    private:
+        static const uint32_t FreeSlot = 0;
+
+        void Insert( size_t Item );
+
+        std::vector<uint32_t> m_Slots;      ///< item position + 1 or FreeSlot, the size is a power of 2
+        std::vector<uint64_t> m_Hashes;     ///< hashes of the items
+};
+
 /// @brief  This structure represents a handle to manage newly adding styles to avoid dublicating
+/// @note   Every component and the whole style are looked up by their hashes
 class StyleList
 {
     public:
@@ -752,6 +982,28 @@ class StyleList
             {
                 return ( horizAlign == ALIGN_H_NONE ) && ( vertAlign == ALIGN_V_NONE ) && ! wrapText && ( textRotation == 0 );
             }
+
+            inline bool operator==( const StylePosInfo & other ) const
+            {
+                return ( horizAlign == other.horizAlign ) && ( vertAlign == other.vertAlign ) &&
+                       ( wrapText == other.wrapText ) && ( textRotation == other.textRotation );
+            }
+        };
+
+        /// @brief  Links of the style to its parts (see STYLE_LINK_* for the order)
+        struct StyleLinks
+        {
+            size_t link[ STYLE_LINK_NUMBER ];
+
+            inline size_t operator[]( size_t i ) const
+            {
+                return link[ i ];
+            }
+
+            inline bool operator==( const StyleLinks & other ) const
+            {
+                return std::equal( link, link + STYLE_LINK_NUMBER, other.link );
+            }
         };
 
     private:
@@ -761,7 +1013,7 @@ class StyleList
         std::vector<Font> m_fonts;		///< fonts set of fonts to be declared
         std::vector<Fill> m_fills;		///< fills set of fills to be declared
         std::vector<NumFormat> m_nums;	///< nums set of number formats to be declared
-        std::vector<std::vector<size_t> > m_styleIndexes;///< styleIndexes vector of a number triplet contains links to style parts:
+        std::vector<StyleLinks> m_styleIndexes;///< styleIndexes vector of a number triplet contains links to style parts:
         ///         first - border id in borders
         ///         second - font id in fonts
         ///         third - fill id in fills
@@ -769,6 +1021,12 @@ class StyleList
 
         std::vector< StylePosInfo > m_stylePos;///< stylePos vector of a number triplet contains style`s alignments and wrap sign:
 
+        ItemHashIndex m_borderIndex;    ///< m_borders by hash
+        ItemHashIndex m_fontIndex;      ///< m_fonts by hash
+        ItemHashIndex m_fillIndex;      ///< m_fills by hash
+        ItemHashIndex m_numIndex;       ///< m_nums by hash
+        ItemHashIndex m_styleIndex;     ///< m_styleIndexes and m_stylePos by hash
+
     public:
         StyleList();
 
@@ -786,7 +1044,7 @@ class StyleList
         inline const std::vector<NumFormat> & GetNumFormats() const { return m_nums; }
 
         /// @brief	For internal use (at the book saving)
-        inline const std::vector<std::vector<size_t> > & GetIndexes() const { return m_styleIndexes; }
+        inline const std::vector<StyleLinks> & GetIndexes() const { return m_styleIndexes; }
 
         /// @brief	For internal use (at the book saving)
         inline const std::vector< StylePosInfo > & GetPositions() const { return m_stylePos; }
@@ -801,6 +1059,67 @@ class StyleList
         size_t Add( const Style & style );
 };
 
+/// @brief  Differential style applied by the conditional formatting rules (dxf), see CWorkbook::AddConditionalStyle
+/// @note   Only the set parts change the look of the cell
+struct ConditionalStyle
+{
+    int32_t fontAttributes;	///< combination of FONT_BOLD, FONT_ITALIC, FONT_UNDERLINED and FONT_STRIKE
+    Color fontColor;		///< fontColor font color
+    Color fillColor;		///< fillColor solid background color
+    Color borderColor;		///< borderColor color of the thin border around the cell
+
+    ConditionalStyle() : fontAttributes( FONT_NORMAL ) {}
+
+    bool operator==( const ConditionalStyle & _style ) const
+    {
+        return ( fontAttributes == _style.fontAttributes ) && ( fontColor == _style.fontColor ) &&
+               ( fillColor == _style.fillColor ) && ( borderColor == _style.borderColor );
+    }
+};
+
+/// @brief  Conditional formatting rule, see CWorksheet::AddConditionalFormat
+/// @note   Formulae are written without leading '=', the references are relative to the top left cell of the range
+struct ConditionalRule
+{
+    enum EType
+    {
+        CELL_IS = 0,    ///< the value of the cell is compared with formula1 (and formula2 for COND_BETWEEN, COND_NOT_BETWEEN)
+        EXPRESSION,     ///< formula1 is true
+        COLOR_SCALE,    ///< the colors of the 2 or 3 thresholds are blended
+        DATA_BAR        ///< bar of barColor between 2 thresholds
+    };
+
+    /// @brief  Threshold of a color scale or a data bar
+    struct Threshold
+    {
+        ECondValueType type;
+        std::string value;	///< value number or formula (not used for COND_VALUE_MIN and COND_VALUE_MAX)
+        Color color;		///< color color of the color scale at the threshold
+
+        Threshold( ECondValueType _type = COND_VALUE_MIN, const std::string & _value = "", Color _color = Color() ) :
+            type( _type ), value( _value ), color( _color ) {}
+    };
+
+    EType type;
+    ECondOperator op;						///< op comparison for CELL_IS
+    std::string formula1, formula2;			///< formulae for CELL_IS and EXPRESSION
+    size_t dxfId;							///< dxfId style for CELL_IS and EXPRESSION (result of CWorkbook::AddConditionalStyle)
+    std::vector<Threshold> thresholds;		///< thresholds for COLOR_SCALE and DATA_BAR
+    Color barColor;							///< barColor for DATA_BAR
+    bool stopIfTrue;						///< stopIfTrue the following rules of the cell are not applied if this one is
+
+    ConditionalRule() : type( CELL_IS ), op( COND_EQUAL ), dxfId( 0 ), stopIfTrue( false ) {}
+
+    static ConditionalRule CellIs( ECondOperator op, const std::string & formula1, size_t dxfId, const std::string & formula2 = "" );
+    static ConditionalRule Expression( const std::string & formula, size_t dxfId );
+    // From the minimum to the maximum value (and through the 50th percentile)
+    static ConditionalRule ColorScale( Color minColor, Color maxColor );
+    static ConditionalRule ColorScale( Color minColor, Color midColor, Color maxColor );
+    static ConditionalRule DataBar( Color color );
+
+    bool IsValid() const;
+};
+
 //Struct for the drawing (chart, image) position description
 struct DrawingPoint
 {
@@ -88,6 +88,9 @@ CWorkbook::CWorkbook( const UniString & UserName ) : m_UserName( UserName )
     m_commLastId = 0;
     m_sheetId = 1;
     m_activeSheetIndex = 0;
+    m_sharedStringsStream = NULL;
+    m_sharedStringsCounts = 0;
+    m_parallelSheets = false;
 
     Style style;
     style.numFormat.id = 0;
@@ -142,6 +145,7 @@ CWorkbook::~CWorkbook()
     for( std::vector<CImage *>::const_iterator it = m_images.begin(); it != m_images.end(); it++ )
         delete * it;
 
+    delete m_sharedStringsStream;
     delete m_pathManager;
 }
 
@@ -400,8 +404,17 @@ CWorksheet & CWorkbook::CreateSheet(const UniString & title, uint32_t frozenWidt
 CWorksheet & CWorkbook::InitWorkSheet( CWorksheet * sheet, const UniString & title )
 {
     sheet->SetTitle( title );
-    sheet->SetSharedStr( & m_sharedStrings );
-    sheet->SetComments( & m_comments );
+    if( m_parallelSheets )
+    {
+        sheet->UseLocalSharedStr( m_sharedStrings.Size() );
+        sheet->UseLocalStyles();
+    }
+    else
+    {
+        sheet->SetSharedStr( & m_sharedStrings );
+        sheet->SetStyles( & m_styleList );
+    }
+    sheet->SetComments( & m_comments, & m_commentsLock );
     m_worksheets.push_back( sheet );
     return * sheet;
 }
@@ -697,7 +710,7 @@ bool CWorkbook::SaveContentType()
     xmlw.TagL( "Override" ).Attr( "PartName", "/xl/theme/theme1.xml" ).Attr( "ContentType", content_theme ).EndL();
     xmlw.TagL( "Override" ).Attr( "PartName", "/xl/styles.xml" ).Attr( "ContentType", content_styles ).EndL();
 
-    if( ! m_sharedStrings.empty() )
+    if( HasSharedStrings() )
         xmlw.TagL( "Override" ).Attr( "PartName", "/xl/sharedStrings.xml" ).Attr( "ContentType", content_sharedStr ).EndL();
 
     for( std::vector<CDrawing *>::const_iterator it = m_drawings.begin(); it != m_drawings.end(); it++ )
@@ -973,13 +986,13 @@ bool CWorkbook::SaveStyles()
     xmlw.TagL( "xf" ).Attr( "numFmtId", 0 ).Attr( "fontId", 0 ).Attr( "fillId", 0 ).Attr( "borderId", 0 ).EndL();
     xmlw.End( "cellStyleXfs" );
 
-    const std::vector<std::vector<size_t> > & styleIndexes = m_styleList.GetIndexes();
+    const std::vector<StyleList::StyleLinks> & styleIndexes = m_styleList.GetIndexes();
     xmlw.Tag( "cellXfs" ).Attr( "count", styleIndexes.size() );
     const std::vector< StyleList::StylePosInfo > & styleAligns = m_styleList.GetPositions();
     assert( styleIndexes.size() == styleAligns.size() );
     for( size_t i = 0; i < styleIndexes.size(); i++ )
     {
-        const std::vector<size_t> & index = styleIndexes[ i ];
+        const StyleList::StyleLinks & index = styleIndexes[ i ];
         const StyleList::StylePosInfo & align = styleAligns[ i ];
 
         xmlw.Tag( "xf" ).Attr( "numFmtId", index[ StyleList::STYLE_LINK_NUM_FORMAT ] );
@@ -1026,7 +1039,7 @@ bool CWorkbook::SaveStyles()
     xmlw.TagL( "cellStyle" ).Attr( "name", "Normal" ).Attr( "xfId", 0 ).Attr( "builtinId", 0 ).EndL();
     xmlw.End( "cellStyles" );
 
-    xmlw.TagL( "dxfs" ).Attr( "count", 0 ).EndL();
+    AddConditionalStyles( xmlw );
     xmlw.TagL( "tableStyles" ).Attr( "count", 0 ).Attr( "defaultTableStyle", "TableStyleMedium2" );
     xmlw.Attr( "defaultPivotStyle", "PivotStyleLight16" ).EndL();
 
@@ -1264,8 +1277,8 @@ void CWorkbook::AddFills( XMLWriter & xmlw ) const
             case PATTERN_SOLID          :   strPattern = "solid";           break;
         }
         xmlw.Attr( "patternType", strPattern );
-        if( it->bgColor != "" ) xmlw.TagL( "bgColor" ).Attr( "rgb", it->bgColor ).EndL();
-        if( it->fgColor != "" ) xmlw.TagL( "fgColor" ).Attr( "rgb", it->fgColor ).EndL();
+        if( it->bgColor.IsSet() ) xmlw.TagL( "bgColor" ).Attr( "rgb", it->bgColor.ToString() ).EndL();
+        if( it->fgColor.IsSet() ) xmlw.TagL( "fgColor" ).Attr( "rgb", it->fgColor.ToString() ).EndL();
         xmlw.End( "patternFill" ).End( "fill" );
     }
     xmlw.End( "fills" );
@@ -1329,13 +1342,70 @@ void CWorkbook::AddBorder( XMLWriter & xmlw, const char * borderName, Border::Bo
     {
         xmlw.Attr( "style", sStyle );
         xmlw.Tag( "color" );
-        if( border.color != "" ) xmlw.Attr( "rgb", border.color );
+        if( border.color.IsSet() ) xmlw.Attr( "rgb", border.color.ToString() );
         else xmlw.Attr( "indexed", 64 );
         xmlw.End( "color" );
     }
     xmlw.End( borderName );
 }
 
+// ****************************************************************************
+/// @brief  Adds a new style of the conditional formatting rules if it is not exists yet
+/// @param  style the style
+/// @return Index of the style (dxfId)
+// ****************************************************************************
+size_t CWorkbook::AddConditionalStyle( const ConditionalStyle & style )
+{
+    assert( IsStyleThread() );
+    if( ! IsStyleThread() ) return 0;
+    std::vector<ConditionalStyle>::const_iterator it = std::find( m_conditionalStyles.begin(), m_conditionalStyles.end(), style );
+    if( it != m_conditionalStyles.end() )
+        return it - m_conditionalStyles.begin();
+    m_conditionalStyles.push_back( style );
+    return m_conditionalStyles.size() - 1;
+}
+
+// ****************************************************************************
+/// @brief  Appends dxfs section into styles file
+/// @param  xmlw reference to xml writer
+/// @return no
+// ****************************************************************************
+void CWorkbook::AddConditionalStyles( XMLWriter & xmlw ) const
+{
+    if( m_conditionalStyles.empty() )
+    {
+        xmlw.TagL( "dxfs" ).Attr( "count", 0 ).EndL();
+        return;
+    }
+    static const char * const Sides[] = { "left", "right", "top", "bottom" };
+    xmlw.Tag( "dxfs" ).Attr( "count", m_conditionalStyles.size() );
+    for( std::vector<ConditionalStyle>::const_iterator it = m_conditionalStyles.begin(); it != m_conditionalStyles.end(); it++ )
+    {
+        xmlw.Tag( "dxf" );
+        if( ( it->fontAttributes != FONT_NORMAL ) || it->fontColor.IsSet() )
+        {
+            xmlw.Tag( "font" );
+            if( it->fontAttributes & FONT_BOLD )        xmlw.TagL( "b" ).EndL();
+            if( it->fontAttributes & FONT_ITALIC )      xmlw.TagL( "i" ).EndL();
+            if( it->fontAttributes & FONT_UNDERLINED )  xmlw.TagL( "u" ).EndL();
+            if( it->fontAttributes & FONT_STRIKE )      xmlw.TagL( "strike" ).EndL();
+            if( it->fontColor.IsSet() )                 xmlw.TagL( "color" ).Attr( "rgb", it->fontColor.ToString() ).EndL();
+            xmlw.End( "font" );
+        }
+        if( it->fillColor.IsSet() )     // Solid fill of dxf takes the color from bgColor
+            xmlw.Tag( "fill" ).Tag( "patternFill" ).TagL( "bgColor" ).Attr( "rgb", it->fillColor.ToString() ).EndL().End( "patternFill" ).End( "fill" );
+        if( it->borderColor.IsSet() )
+        {
+            xmlw.Tag( "border" );
+            for( size_t i = 0; i < sizeof( Sides ) / sizeof( Sides[ 0 ] ); i++ )
+                xmlw.Tag( Sides[ i ] ).Attr( "style", "thin" ).TagL( "color" ).Attr( "rgb", it->borderColor.ToString() ).EndL().End( Sides[ i ] );
+            xmlw.End( "border" );
+        }
+        xmlw.End( "dxf" );
+    }
+    xmlw.End( "dxfs" );
+}
+
 void CWorkbook::AddFontInfo( XMLWriter & xmlw, const Font & font, const char * FontTagName, int32_t Charset ) const
 {
     int32_t attributes = font.attributes;
@@ -1351,8 +1421,8 @@ void CWorkbook::AddFontInfo( XMLWriter & xmlw, const Font & font, const char * F
     xmlw.TagL( "sz" ).Attr( "val", font.size ).EndL();
     xmlw.TagL( FontTagName ).Attr( "val", font.name ).EndL();
     xmlw.TagL( "charset" ).Attr( "val", Charset ).EndL();
-    if( font.theme || ( font.color == "" ) ) xmlw.TagL( "color" ).Attr( "theme", 1 ).EndL();
-    else xmlw.TagL( "color" ).Attr( "rgb", font.color ).EndL();
+    if( font.theme || ! font.color.IsSet() ) xmlw.TagL( "color" ).Attr( "theme", 1 ).EndL();
+    else xmlw.TagL( "color" ).Attr( "rgb", font.color.ToString() ).EndL();
 }
 
 void CWorkbook::AddImagesExtensions( XMLWriter & xmlw ) const
@@ -1417,7 +1487,7 @@ bool CWorkbook::SaveComments()
 
     std::vector<Comment *> sheet_comments;
     std::vector<std::vector<Comment *> > comments;
-    std::sort( m_comments.begin(), m_comments.end() );
+    std::stable_sort( m_comments.begin(), m_comments.end() );    // Keep the order of the comments of a sheet
 
     size_t active_sheet = m_comments[0].sheetIndex;
     for( size_t i = 0; i < m_comments.size(); i++ )
@@ -1457,6 +1527,7 @@ bool CWorkbook::SaveCommentList( const std::vector<Comment *> & comments )
         FileName << "/xl/comments" << comments[ 0 ]->sheetIndex << ".xml";
 
         XMLWriter xmlw( m_pathManager->RegisterXML( FileName.str() ) );
+        xmlw.SetControlChars( XMLWriter::CONTROL_CHARS_ENCODE );  // Texts of comments are ST_Xstring
         xmlw.Tag( "comments" ).Attr( "xmlns", ns_book );
         xmlw.Tag( "authors" ).TagOnlyContent( "author", m_UserName ).End().Tag( "commentList" );
         for( std::vector<Comment *>::const_iterator it = comments.begin(); it != comments.end(); it++ )
@@ -1497,6 +1568,12 @@ bool CWorkbook::SaveCommentList( const std::vector<Comment *> & comments )
 // ****************************************************************************
 bool CWorkbook::SaveAllDataToFiles()
 {
+    for( std::vector<CWorksheet *>::const_iterator it = m_worksheets.begin(); it != m_worksheets.end(); it++ )
+    {
+        ( * it )->MergeSharedStrings( m_sharedStrings );   // Sheets filled in parallel
+        ( * it )->MergeStyles( m_styleList );
+    }
+
     if( !SaveCore() || !SaveApp() || !SaveContentType() || !SaveTheme() ||
             !SaveComments() || !SaveSharedStrings() || !SaveStyles() || !SaveWorkbook() )
         return false;
@@ -1589,25 +1666,118 @@ void CWorkbook::AddCommentDrawing( XMLWriter & xmlw, const Comment & comment )
 bool CWorkbook::SaveSharedStrings()
 {
     // [- zip/xl/sharedStrings.xml
-    if( m_sharedStrings.empty() ) return true;
+    if( m_sharedStrings.IsStreamed() ) return EndSharedStringsStream();
+    if( m_sharedStrings.Empty() ) return true;
 
     XMLWriter xmlw( m_pathManager->RegisterXML( "/xl/sharedStrings.xml" ) );
-    xmlw.Tag( "sst" ).Attr( "xmlns", ns_book ).Attr( "count", m_sharedStrings.size() ).Attr( "uniqueCount", m_sharedStrings.size() );
-
-    std::vector< std::pair<const std::string, uint64_t> *> pointers_to_hash;
-    pointers_to_hash.resize( m_sharedStrings.size() );
-    for( std::map<std::string, uint64_t>::iterator it = m_sharedStrings.begin(); it != m_sharedStrings.end(); it++ )
-        pointers_to_hash[it->second] = & ( * it );
+    xmlw.SetControlChars( XMLWriter::CONTROL_CHARS_ENCODE );  // Cell texts are ST_Xstring, keep control characters as _xHHHH_
+    xmlw.Tag( "sst" ).Attr( "xmlns", ns_book ).Attr( "count", m_sharedStrings.Size() ).Attr( "uniqueCount", m_sharedStrings.Size() );
 
-    std::vector< std::pair<const std::string, uint64_t> *>::const_iterator it = pointers_to_hash.begin();
-    for( ; it != pointers_to_hash.end(); it++ )
-        xmlw.Tag( "si" ).TagOnlyContent( "t", ( * it )->first ).End( "si" );
+    for( size_t i = 0; i < m_sharedStrings.Size(); i++ )
+        xmlw.Tag( "si" ).TagOnlyContent( "t", m_sharedStrings.String( i ), m_sharedStrings.Length( i ) ).End( "si" );
 
     xmlw.End( "sst" );
     // zip/xl/sharedStrings.xml -]
     return true;
 }
 
+// Space for ' count="N" uniqueCount="N"' in the streamed sst
+static const size_t SharedStringsCountsSize = 64;
+
+// ****************************************************************************
+/// @brief  Gives the own string tables to the sheets to be added
+/// @return Boolean result of the operation (false if there are sheets already)
+/// @note   CWorkbook::AddStyle can be called only from the calling thread after this
+// ****************************************************************************
+bool CWorkbook::EnableParallelSheets()
+{
+    if( ! m_worksheets.empty() )
+        return m_parallelSheets;
+    m_parallelSheets = true;
+    m_styleThread = std::this_thread::get_id();
+    return true;
+}
+
+// ****************************************************************************
+/// @brief  Adds the string into the shared strings
+/// @param  value the string
+/// @return Handle of the string (invalid if the sheets filled in parallel are added already)
+// ****************************************************************************
+SharedStringHandle CWorkbook::RegisterSharedString( const std::string & value )
+{
+    if( m_parallelSheets && ! m_worksheets.empty() )    // The sheets number their own strings after the registered ones
+        return SharedStringHandle();
+    return SharedStringHandle( m_sharedStrings.Add( value ) );
+}
+
+// ****************************************************************************
+/// @brief  Adds the strings into the shared strings
+/// @param  values the strings
+/// @return Handles of the strings in the same order
+// ****************************************************************************
+std::vector<SharedStringHandle> CWorkbook::RegisterSharedStrings( const std::vector<std::string> & values )
+{
+    std::vector<SharedStringHandle> Result;
+    Result.reserve( values.size() );
+    for( std::vector<std::string>::const_iterator it = values.begin(); it != values.end(); it++ )
+        Result.push_back( RegisterSharedString( * it ) );
+    return Result;
+}
+
+// ****************************************************************************
+/// @brief  Switches the shared strings to the streamed mode
+/// @param  window maximum number of the remembered strings, 0 - unbounded
+/// @return Boolean result of the operation (false if there are shared strings already)
+// ****************************************************************************
+bool CWorkbook::StreamSharedStrings( size_t window )
+{
+    if( m_sharedStrings.IsStreamed() )
+        return true;
+    if( ! m_sharedStrings.Empty() )
+        return false;
+
+    m_sharedStringsFile = m_pathManager->RegisterXML( "/xl/sharedStrings.xml" );
+    m_sharedStringsStream = new XMLWriter( m_sharedStringsFile );
+    m_sharedStringsStream->SetControlChars( XMLWriter::CONTROL_CHARS_ENCODE );  // Cell texts are ST_Xstring, keep control characters as _xHHHH_
+    m_sharedStringsStream->Tag( "sst" ).Attr( "xmlns", ns_book );
+    m_sharedStringsCounts = m_sharedStringsStream->GetCurrentPosition();
+    char Space[ SharedStringsCountsSize ];     // Filled by EndSharedStringsStream
+    std::memset( Space, ' ', sizeof( Space ) );
+    m_sharedStringsStream->Raw( Space, sizeof( Space ) );
+    m_sharedStrings.StartStream( * m_sharedStringsStream, window );
+    return m_sharedStringsStream->IsOk();
+}
+
+// ****************************************************************************
+/// @brief  Completes xl/sharedStrings.xml in the streamed mode
+/// @return Boolean result of the operation
+// ****************************************************************************
+bool CWorkbook::EndSharedStringsStream()
+{
+    if( m_sharedStringsStream == NULL )
+        return true;
+    m_sharedStrings.EndStream();
+    m_sharedStringsStream->End( "sst" );
+    const bool Ok = m_sharedStringsStream->Flush();
+    delete m_sharedStringsStream;
+    m_sharedStringsStream = NULL;
+    if( ! Ok )
+        return false;
+    try
+    {
+        std::fstream f( m_sharedStringsFile.c_str() );
+        if( ! f.is_open() )
+            return false;
+        f.seekp( m_sharedStringsCounts );
+        f << " count=\"" << m_sharedStrings.Size() << "\" uniqueCount=\"" << m_sharedStrings.Size() << '\"';
+    }
+    catch( ... )
+    {
+        return false;
+    }
+    return true;
+}
+
 // ****************************************************************************
 /// @brief  ...
 /// @return Boolean result of the operation
@@ -1645,7 +1815,7 @@ bool CWorkbook::SaveWorkbook()
             sprintf( szId, "rId%u", unsigned( id++ ) );
             xmlw.TagL( "Relationship" ).Attr( "Id", szId ).Attr( "Type", type_chain ).Attr( "Target", "calcChain.xml" ).EndL();
         }
-        if( ! m_sharedStrings.empty() )
+        if( HasSharedStrings() )
         {
             //sprintf( szId, "rId%zu", id++ );
             sprintf( szId, "rId%u", unsigned( id++ ) );
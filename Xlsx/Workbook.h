@@ -23,10 +23,13 @@
 #define XLSX_WORKBOOK_H
 
 #include <cstdio>
+#include <mutex>
+#include <thread>
 
 #include "SimpleXlsxDef.h"
 
 #include "Chartsheet.h"
+#include "SharedStrings.h"
 #include "Worksheet.h"
 
 namespace SimpleXlsx
@@ -50,8 +53,12 @@ class CWorkbook
         std::vector<CChart *>       m_charts;           ///< a series of charts
         std::vector<CDrawing *>     m_drawings;         ///< a series of drawings
         std::vector<CImage *>       m_images;           ///< a series of images
-        std::map<std::string, uint64_t> m_sharedStrings;///<
+        SharedStringTable           m_sharedStrings;    ///< unique strings of all sheets
+        XMLWriter          *        m_sharedStringsStream;  ///< xl/sharedStrings.xml in the streamed mode
+        std::string                 m_sharedStringsFile;
+        std::streamoff              m_sharedStringsCounts;  ///< offset of the space for count and uniqueCount
         std::vector<Comment>		m_comments;			///<
+        std::mutex                  m_commentsLock;     ///< guards m_comments filled by the sheets
 
         size_t                      m_commLastId;		///< m_commLastId comments counter
         UniString                   m_UserName;
@@ -59,6 +66,9 @@ class CWorkbook
         size_t                      m_activeSheetIndex; ///< Index of active (opened) sheet
 
         StyleList                   m_styleList;        ///< All registered styles
+        std::vector<ConditionalStyle> m_conditionalStyles;  ///< Styles of the conditional formatting rules (dxfs)
+        std::thread::id             m_styleThread;      ///< the only thread adding the styles in the parallel mode
+        bool                        m_parallelSheets;   ///< sheets have own string tables (see EnableParallelSheets)
         mutable std::string         m_currencySymbol;   ///<
 
         PathManager        *        m_pathManager;      ///<
@@ -171,7 +181,13 @@ class CWorkbook
         // *INDENT-OFF*   For AStyle tool
         //Adds a new style into collection if it is not exists yet.
         //Return style index that should be used at data appending to a data sheet.
-        inline size_t AddStyle( const Style & style )           { return m_styleList.Add( style ); }
+        //With the parallel sheets only the thread that called EnableParallelSheets adds styles here (0 is returned
+        //to the other threads), the threads filling the sheets use CWorksheet::AddStyle.
+        inline size_t AddStyle( const Style & style )           { assert( IsStyleThread() ); return IsStyleThread() ? m_styleList.Add( style ) : 0; }
+        //Adds a new style of the conditional formatting rules if it is not exists yet, returns its index (dxfId)
+        //With the parallel sheets only the thread that called EnableParallelSheets adds them (0 is returned to the other threads),
+        //the indexes can be passed to the threads filling the sheets.
+        size_t AddConditionalStyle( const ConditionalStyle & style );
         //Vector with exist fonts
         inline const std::vector<Font> & GetFonts()	const       { return m_styleList.GetFonts(); }
 
@@ -180,8 +196,43 @@ class CWorkbook
         //Set active (opened) sheet (start from 0).
         inline CWorkbook & SetActiveSheet( size_t index )           { m_activeSheetIndex = index; return * this; }
         inline CWorkbook & SetActiveSheet( const CSheet & sheet )   { m_activeSheetIndex = sheet.GetIndex() - 1; return * this; }
+
+        //Capacity hint: the expected number of unique cell strings and their total length in UTF-8 (0 if unknown)
+        inline void ReserveSharedStrings( size_t count, size_t totalLength = 0 )   { m_sharedStrings.Reserve( count, totalLength ); }
         // *INDENT-ON*   For AStyle tool
 
+        // Streamed shared strings: the new strings are written into xl/sharedStrings.xml at once, only
+        // their fingerprints and the texts of the repeated strings are kept in memory (the texts for the
+        // comparison go to the temporary file). Must be called before the first string cell is added.
+        // window > 0 bounds the memory: only that many recently used strings (with their texts) are
+        // remembered, and a forgotten string is written again (approximate deduplication)
+        bool StreamSharedStrings( size_t window = 0 );
+        // *INDENT-OFF*   For AStyle tool
+        inline SharedStringStats GetSharedStringStats() const   { return m_sharedStrings.GetStats(); }
+        // *INDENT-ON*   For AStyle tool
+
+        // Distinct sheets can be filled from different threads (one thread per sheet) if this is called
+        // before the first sheet is added. Every sheet collects its strings in the own table, the tables are
+        // merged in the order of the sheets at saving, so the indexes are the same for any number of threads.
+        // Strings to be added by handles must be registered before the sheets are added.
+        // Workbook methods must be called from the thread that called this. The styles registered by
+        // CWorkbook::AddStyle before the sheets are filled can be used in any sheet; a thread filling the
+        // sheet adds new styles by CWorksheet::AddStyle, the sheet styles are merged in the order of the
+        // sheets at saving too.
+        bool EnableParallelSheets();
+
+        // Adds the string into the shared strings and returns the handle for CWorksheet::AddCell.
+        // Cells with the handle skip the lookup of the string; the text is never treated as a formula.
+        // With the parallel sheets the strings can be registered only before the first sheet is added
+        // (the invalid handle is returned after that).
+        SharedStringHandle RegisterSharedString( const std::string & value );
+        inline SharedStringHandle RegisterSharedString( const std::wstring & value )
+        {
+            return RegisterSharedString( UTF8Encoder::From_wstring( value ) );
+        }
+        // The handles are returned in the order of the values
+        std::vector<SharedStringHandle> RegisterSharedStrings( const std::vector<std::string> & values );
+
         // Adding a descriptive name to represent a constant value.
         CWorkbook & AddDefinedName( const UniString & Name, double Constant, const UniString & Comment = "", const CSheet * ScopeSheet = NULL );
         // Adding a descriptive name to represent a single cell.
@@ -237,6 +288,11 @@ class CWorkbook
         bool SaveChain();
         bool SaveComments();
         bool SaveSharedStrings();
+        bool EndSharedStringsStream();
+        // *INDENT-OFF*   For AStyle tool
+        inline bool HasSharedStrings() const    { return ! m_sharedStrings.Empty() || m_sharedStrings.IsStreamed(); }
+        inline bool IsStyleThread() const       { return ! m_parallelSheets || ( std::this_thread::get_id() == m_styleThread ); }
+        // *INDENT-ON*   For AStyle tool
         bool SaveWorkbook();
         bool SaveCommentList( const std::vector<Comment *> & comments );
         bool SaveAllDataToFiles();
@@ -249,6 +305,7 @@ class CWorkbook
         void AddBorders( XMLWriter & xmlw ) const;
         void AddBorder( XMLWriter & xmlw, const char * borderName, Border::BorderItem border ) const;
         void AddFontInfo( XMLWriter & xmlw, const Font & font, const char * FontTagName, int32_t Charset ) const;
+        void AddConditionalStyles( XMLWriter & xmlw ) const;
         void AddImagesExtensions( XMLWriter & xmlw ) const;
 
         std::string GetFormatCodeString( const NumFormat & fmt ) const;
@@ -22,34 +22,129 @@
 #include <stdlib.h>
 
 #include <algorithm>
+#include <cstdio>
 #include <cstring>
 #include <iomanip>
 
 #include "Worksheet.h"
 #include "XlsxHeaders.h"
 #include "Drawing.h"
+#include "SharedStrings.h"
 
 #include "../PathManager.hpp"
 #include "../XMLWriter.hpp"
 
 namespace SimpleXlsx
 {
+// Pre-rendered pieces of the cell markup
+static const char CellBegin[] = "<c";
+static const char CellRefBegin[] = " r=\"";
+static const char CellStyleBegin[] = " s=\"";
+static const char AttrEnd[] = "\"";
+static const char CellSharedStr[] = " t=\"s\"";
+static const char CellInlineStr[] = " t=\"inlineStr\"><is><t>";
+static const char CellInlineStrEnd[] = "</t></is></c>";
+static const char CellValue[] = "><v>";
+static const char CellValueEnd[] = "</v></c>";
+static const char CellEmptyEnd[] = "/>";
+static const char RowDescent[] = " x14ac:dyDescent=\"0.25\"";
+
+// Size of the blocks read by RemapIndexes
+static const size_t RemapBlockSize = 1 << 20;
+
+// Rows of AddColumns written after one conversion of the time columns
+static const size_t BlockChunkRows = 4096;
+
 // ****************************************************************************
-/// @brief  Appends another a group of cells into a row
-/// @param  data template data value
-/// @param	style style index
+/// @brief  Writes the beginning of the next cell: the reference (if needed) and the style
+/// @param	style_id style index
+/// @return no
+// ****************************************************************************
+inline void CWorksheet::BeginCell( size_t style_id )
+{
+    BeginCellRef();
+    if( style_id != 0 )    // default style is not necessary to sign explicitly
+        m_XMLWriter->Lit( CellStyleBegin ).Value( style_id ).Lit( AttrEnd );
+}
+
+// ****************************************************************************
+/// @brief  Writes the beginning of the next cell with the pre-rendered style attribute
+/// @param	style style attribute
+/// @return no
+// ****************************************************************************
+inline void CWorksheet::BeginCell( const CellStyleAttr & style )
+{
+    BeginCellRef();
+    m_XMLWriter->Raw( style.text, style.len );
+}
+
+// ****************************************************************************
+/// @brief  Writes the beginning of the next cell and its reference (if needed)
+/// @return no
+// ****************************************************************************
+inline void CWorksheet::BeginCellRef()
+{
+    const uint32_t FactColumn = m_offset_column + m_current_column;
+    m_current_column++;
+    UseCell( FactColumn );
+    m_XMLWriter->Fragment().Lit( CellBegin );
+    if( ! m_compact || ( FactColumn != m_LastWrittenCol + 1 ) )  // Cell without reference follows the previous one
+    {
+        CellCoord::TConvBuf Ref;
+        const size_t RefLen = CellRef( FactColumn, Ref );
+        m_XMLWriter->Lit( CellRefBegin ).Raw( Ref, RefLen ).Lit( AttrEnd );
+    }
+    m_LastWrittenCol = FactColumn;
+}
+
+// ****************************************************************************
+/// @brief  Writes the number of the cell
+/// @param  value the value
+/// @param  Col column of the cell (the floating point values are rounded by the decimals of the column)
 /// @return no
 // ****************************************************************************
 template<typename T>
-static CWorksheet & AddCellRoutineTempl( T data, size_t style, const std::string & CellCoord, XMLWriter & xmlw, CWorksheet * WorkSheet )
+inline void CWorksheet::WriteNumber( T value, uint32_t )
+{
+    m_XMLWriter->Value( value );
+}
+
+inline void CWorksheet::WriteNumber( float value, uint32_t Col )
 {
-    xmlw.Tag( "c" ).Attr( "r", CellCoord );
-    if( style != 0 )    // default style is not necessary to sign explicitly
-        xmlw.Attr( "s", style );
-    xmlw.TagOnlyContent( "v", data ).End( "c" );
-    return * WorkSheet;
+    if( ( Col < m_columnDecimals.size() ) && ( m_columnDecimals[ Col ] >= 0 ) )
+        WriteDecimal( value, m_columnDecimals[ Col ] );
+    else m_XMLWriter->Value( value );
 }
 
+inline void CWorksheet::WriteNumber( double value, uint32_t Col )
+{
+    if( ( Col < m_columnDecimals.size() ) && ( m_columnDecimals[ Col ] >= 0 ) )
+        WriteDecimal( value, m_columnDecimals[ Col ] );
+    else m_XMLWriter->Value( value );
+}
+
+inline void CWorksheet::WriteDecimal( double value, int decimals )
+{
+    char Buffer[ NumberToChars::BufferSize ];
+    m_XMLWriter->Raw( Buffer, NumberToChars::Fixed( value, decimals, Buffer ) );
+}
+
+// ****************************************************************************
+/// @brief  Appends the cell with the value
+/// @param  data template data value
+/// @param	style_id style index
+/// @return Reference to this object
+// ****************************************************************************
+template<typename T>
+CWorksheet & CWorksheet::AddCellValue( T data, size_t style_id )
+{
+    const uint32_t Col = m_offset_column + m_current_column;
+    BeginCell( style_id );
+    m_XMLWriter->Lit( CellValue );
+    WriteNumber( data, Col );
+    m_XMLWriter->Lit( CellValueEnd );
+    return * this;
+}
 
 // ****************************************************************************
 /// @brief      The class constructor
@@ -116,6 +211,8 @@ CWorksheet::CWorksheet( size_t index, uint32_t width, uint32_t height, const std
 CWorksheet::~CWorksheet()
 {
     delete m_XMLWriter;
+    delete m_localStrings;
+    delete m_localStyleList;
 }
 
 // ****************************************************************************
@@ -129,6 +226,10 @@ void CWorksheet::Init( uint32_t frozenWidth, uint32_t frozenHeight, const std::v
 {
     m_isOk = true;
     m_row_opened = false;
+    m_sheetDataOpened = false;
+    m_compact = false;
+    m_rowStyle = 0;
+    m_stringMode = STRINGS_DEFAULT;
     m_current_column = 0;
     m_offset_column = 0;
     m_title = "Sheet 1";
@@ -136,9 +237,16 @@ void CWorksheet::Init( uint32_t frozenWidth, uint32_t frozenHeight, const std::v
     m_withComments = false;
     m_calcChain.clear();
     m_sharedStrings = NULL;
+    m_localStrings = NULL;
+    m_sharedBase = 0;
+    m_styleList = NULL;
+    m_localStyleList = NULL;
     m_comments = NULL;
+    m_commentsLock = NULL;
     m_mergedCells.clear();
-    m_row_index = 0;
+    SetRowIndex( 0 );
+    m_RowFirstUsedCol = m_RowLastUsedCol = NoColumn;
+    m_ColumnNames = CellCoord::ColumnNames();
     m_page_orientation = PAGE_PORTRAIT;
 
     std::stringstream FileName;
@@ -150,10 +258,11 @@ void CWorksheet::Init( uint32_t frozenWidth, uint32_t frozenHeight, const std::v
         m_isOk = false;
         return;
     }
+    m_XMLWriter->SetControlChars( XMLWriter::CONTROL_CHARS_ENCODE );  // Inline strings and formulae are ST_Xstring
 
     m_XMLWriter->Tag( "worksheet" ).Attr( "xmlns", ns_book ).Attr( "xmlns:r", ns_book_r ).Attr( "xmlns:mc", ns_mc ).Attr( "mc:Ignorable", "x14ac" ).Attr( "xmlns:x14ac", ns_x14ac );
     // Tag "dimension"
-    m_DimensionOffset = m_XMLWriter->TagL( "dimension" ).GetCurrentPosition() + 7;  // +7 is:  ref="
+    m_DimensionOffset = m_XMLWriter->TagL( "dimension" ).GetCurrentPosition() + 6;  // +6 is:  ref="
     m_UsedCellFirst.row = m_UsedCellFirst.col = (std::numeric_limits< uint32_t >::max)();
     CellCoord::TConvBuf TmpBuf;     // Empty space for fact dimension
     std::memset( TmpBuf, ' ', CellCoord::ConvBufSize );
@@ -165,35 +274,155 @@ void CWorksheet::Init( uint32_t frozenWidth, uint32_t frozenHeight, const std::v
     m_XMLWriter->End( "sheetView" ).End( "sheetViews" );
 
     m_XMLWriter->TagL( "sheetFormatPr" ).Attr( "defaultRowHeight", 15 ).Attr( "x14ac:dyDescent", 0.25 ).EndL();
-    if( ! colWidths.empty() )
+    m_colWidths = colWidths;    // "cols" and "sheetData" are written before the first row, column styles can be set until then
+}
+
+// ****************************************************************************
+/// @brief  Writes the column settings and opens sheetData tag
+/// @return no
+// ****************************************************************************
+void CWorksheet::OpenSheetData()
+{
+    m_sheetDataOpened = true;
+    if( m_columnStyles.empty() )
+    {
+        if( ! m_colWidths.empty() )
+        {
+            m_XMLWriter->Tag( "cols" );
+            for( std::vector<ColumnWidth>::const_iterator it = m_colWidths.begin(); it != m_colWidths.end(); it++ )
+                m_XMLWriter->TagL( "col" ).Attr( "min", it->colFrom + 1 ).Attr( "max", it->colTo + 1 ).Attr( "width", it->width ).EndL();
+            m_XMLWriter->End( "cols" );
+        }
+    }
+    else
     {
+        // "col" elements must not overlap, so the widths and the styles are joined per column
+        uint32_t ColCount = static_cast< uint32_t >( m_columnStyles.size() );
+        for( std::vector<ColumnWidth>::const_iterator it = m_colWidths.begin(); it != m_colWidths.end(); it++ )
+            ColCount = (std::max)( ColCount, (std::min)( it->colTo, CellCoord::MaxCols - 1 ) + 1 );
+        std::vector<float> Widths( ColCount, 0.0f );    // 0 - default width
+        for( std::vector<ColumnWidth>::const_iterator it = m_colWidths.begin(); it != m_colWidths.end(); it++ )
+            for( uint32_t Col = it->colFrom; ( Col <= it->colTo ) && ( Col < ColCount ); Col++ )
+                Widths[ Col ] = it->width;
+        m_columnStyles.resize( ColCount, 0 );
+
         m_XMLWriter->Tag( "cols" );
-        for( std::vector<ColumnWidth>::const_iterator it = colWidths.begin(); it != colWidths.end(); it++ )
-            m_XMLWriter->TagL( "col" ).Attr( "min", it->colFrom + 1 ).Attr( "max", it->colTo + 1 ).Attr( "width", it->width ).EndL();
+        for( uint32_t From = 0; From < ColCount; )
+        {
+            uint32_t To = From;
+            while( ( To + 1 < ColCount ) && ( Widths[ To + 1 ] == Widths[ From ] ) && ( m_columnStyles[ To + 1 ] == m_columnStyles[ From ] ) )
+                To++;
+            if( ( Widths[ From ] > 0.0f ) || ( m_columnStyles[ From ] != 0 ) )
+            {
+                m_XMLWriter->TagL( "col" ).Attr( "min", From + 1 ).Attr( "max", To + 1 );
+                if( Widths[ From ] > 0.0f )
+                    m_XMLWriter->Attr( "width", Widths[ From ] );
+                if( m_columnStyles[ From ] != 0 )
+                    m_XMLWriter->Attr( "style", m_columnStyles[ From ] );
+                m_XMLWriter->EndL();
+            }
+            From = To + 1;
+        }
         m_XMLWriter->End( "cols" );
     }
     m_XMLWriter->Tag( "sheetData" );    // open sheetData tag
 }
 
 // ****************************************************************************
-/// @brief	Generates a header for another row
+/// @brief	Sets the style of the columns for the cells that are not written (must be called before the first row)
+/// @param	colFrom first column (starts from 0)
+/// @param	colTo last column (starts from 0)
+/// @param	style_id style index
+/// @return	Reference to this object
+// ****************************************************************************
+CWorksheet & CWorksheet::SetColumnStyle( uint32_t colFrom, uint32_t colTo, size_t style_id )
+{
+    assert( ! m_sheetDataOpened );
+    if( m_sheetDataOpened || ( colFrom > colTo ) || ( colFrom >= CellCoord::MaxCols ) )
+        return * this;
+    colTo = (std::min)( colTo, CellCoord::MaxCols - 1 );
+    if( m_columnStyles.size() <= colTo )
+        m_columnStyles.resize( colTo + 1, 0 );
+    std::fill( m_columnStyles.begin() + colFrom, m_columnStyles.begin() + colTo + 1, style_id );
+    return * this;
+}
+
+// ****************************************************************************
+/// @brief	Sets the storage of the following strings of the columns
+/// @param	colFrom first column (starts from 0)
+/// @param	colTo last column (starts from 0)
+/// @param	mode storage of the strings, STRINGS_DEFAULT - the mode of the sheet
+/// @return	Reference to this object
+// ****************************************************************************
+CWorksheet & CWorksheet::SetColumnStringMode( uint32_t colFrom, uint32_t colTo, EStringMode mode )
+{
+    if( ( colFrom > colTo ) || ( colFrom >= CellCoord::MaxCols ) )
+        return * this;
+    colTo = (std::min)( colTo, CellCoord::MaxCols - 1 );
+    if( m_columnStringModes.size() <= colTo )
+        m_columnStringModes.resize( colTo + 1, STRINGS_DEFAULT );
+    std::fill( m_columnStringModes.begin() + colFrom, m_columnStringModes.begin() + colTo + 1, mode );
+    return * this;
+}
+
+// ****************************************************************************
+/// @brief	Sets the rounding of the following floating point values of the columns
+/// @param	colFrom first column (starts from 0)
+/// @param	colTo last column (starts from 0)
+/// @param	decimals digits after the point (0 to NumberToChars::MaxDecimals), -1 - the shortest text of the exact value
+/// @return	Reference to this object
+/// @note	The values are written by the scaled integers (e.g. 19.99 for 19.9899999 and 2 decimals), the trailing zeros are omitted
+// ****************************************************************************
+CWorksheet & CWorksheet::SetColumnDecimals( uint32_t colFrom, uint32_t colTo, int decimals )
+{
+    if( ( colFrom > colTo ) || ( colFrom >= CellCoord::MaxCols ) )
+        return * this;
+    colTo = (std::min)( colTo, CellCoord::MaxCols - 1 );
+    if( m_columnDecimals.size() <= colTo )
+        m_columnDecimals.resize( colTo + 1, -1 );
+    decimals = decimals < 0 ? -1 : ( decimals > NumberToChars::MaxDecimals ? NumberToChars::MaxDecimals : decimals );
+    std::fill( m_columnDecimals.begin() + colFrom, m_columnDecimals.begin() + colTo + 1, static_cast<int8_t>( decimals ) );
+    return * this;
+}
+
+// ****************************************************************************
+/// @brief	Generates a header for the row with the given index
+/// @param	rowIndex index of the row (starts from 1), must be greater than the index of the previous row
 /// @param	height row height (default if 0)
 /// @return	Reference to this object
 // ****************************************************************************
-CWorksheet & CWorksheet::BeginRow( double height )
+CWorksheet & CWorksheet::BeginRowAt( uint32_t rowIndex, double height )
 {
     if( m_row_opened )
         m_XMLWriter->End( "row" );
-    m_XMLWriter->Tag( "row" ).Attr( "r", ++m_row_index ).Attr( "x14ac:dyDescent", 0.25 );
-
-    if( height > 0.0 )
-        m_XMLWriter->Attr( "ht", height ).Attr( "customHeight", 1 );
+    CommitUsedCells();
+    SetRowIndex( NextRowIndex( rowIndex ) );
+    if( ! m_sheetDataOpened )
+        OpenSheetData();
+    m_XMLWriter->Tag( "row" ).Attr( "r", m_RowRef, m_RowRefLen );
+    if( ! m_compact )
+        m_XMLWriter->Lit( RowDescent );
+    AddRowAttributes( height );
 
     m_current_column = 0;
     m_row_opened = true;
     return * this;
 }
 
+// ****************************************************************************
+/// @brief	Skips the rows, nothing is written for them
+/// @param	count number of the rows to skip
+/// @return	Reference to this object
+// ****************************************************************************
+CWorksheet & CWorksheet::SkipRows( uint32_t count )
+{
+    EndRow();
+    CommitUsedCells();
+    SetRowIndex( m_row_index + count );
+    m_current_column = 0;
+    return * this;
+}
+
 // ****************************************************************************
 /// @brief	Closes previously began row
 /// @return	Reference to this object
@@ -203,60 +432,60 @@ CWorksheet & CWorksheet::EndRow()
     if( ! m_row_opened )
         return * this;
     m_XMLWriter->End( "row" );
+    CommitUsedCells();
     m_row_opened = false;
     return * this;
 }
 
 // ****************************************************************************
 /// @brief	Add string-formatted cell with specified style
-/// @param	data reference to data
+/// @param	value pointer to the string (may be not null-terminated)
+/// @param	len length of the string
+/// @param	style_id style index
+/// @param	mode storage of the string (STRINGS_DEFAULT - the mode of the column or the sheet)
 /// @return	Reference to this object
 // ****************************************************************************
-CWorksheet & CWorksheet::AddCell( const char * value, size_t style_id )
+CWorksheet & CWorksheet::AddStringCell( const char * value, size_t len, size_t style_id, EStringMode mode )
 {
-    const uint32_t FactColumn = m_offset_column + m_current_column;
-    if( value[ 0 ] != '\0' )
+    if( ( len > 0 ) && ( value[ 0 ] == '=' ) )
     {
-        const std::string szCoord = CellCoord( m_row_index, FactColumn ).ToString();
-        m_XMLWriter->Tag( "c" ).Attr( "r", szCoord );
-
+        const uint32_t FactColumn = m_offset_column + m_current_column;
+        m_current_column++;
+        UseCell( FactColumn );
+        m_LastWrittenCol = FactColumn;
+        CellCoord::TConvBuf Ref;
+        const size_t RefLen = CellRef( FactColumn, Ref );
+        m_XMLWriter->Tag( "c" ).Attr( "r", Ref, RefLen );
         if( style_id != 0 )
             m_XMLWriter->Attr( "s", style_id );  // default style is not necessary to sign explisitly
+        m_XMLWriter->TagOnlyContent( "f", value + 1, len - 1 ).End( "c" );
 
-        if( value[ 0 ] == '=' )
+        m_withFormula = true;
+        m_calcChain.push_back( std::string( Ref, RefLen ) );
+    }
+    else if( len > 0 )
+    {
+        const EStringMode CellMode = StringMode( m_offset_column + m_current_column, mode, value, len );
+        BeginCell( style_id );
+        AddStringValue( value, len, CellMode );
+    }
+    ///  empty cell with style   ---
+    else if( style_id != 0 )
+    {
+        const uint32_t FactColumn = m_offset_column + m_current_column;
+        if( m_compact && ( style_id == DefaultCellStyle( FactColumn ) ) )  // Missing cell gets the same style
         {
-            m_XMLWriter->TagOnlyContent( "f", value + 1 );
-
-            m_withFormula = true;
-            m_calcChain.push_back( szCoord );
+            m_current_column++;
+            UseCell( FactColumn );
         }
         else
         {
-            assert( m_sharedStrings != NULL );
-            uint64_t str_index = 0;
-            std::string StdStrVal( value );
-            std::map<std::string, uint64_t>::iterator it = m_sharedStrings->find( StdStrVal );
-            if( it == m_sharedStrings->end() )
-            {
-                str_index = m_sharedStrings->size();
-                ( *m_sharedStrings )[ StdStrVal ] = str_index;
-            }
-            else str_index = it->second;
-            m_XMLWriter->Attr( "t", "s" ).TagOnlyContent( "v", str_index );
+            BeginCell( style_id );
+            m_XMLWriter->Lit( CellEmptyEnd );
         }
-        m_XMLWriter->End( "c" );
-        CheckUsedCells( FactColumn );
     }
     ///  empty cell with style   ---
-    else if( style_id != 0 )
-    {
-        CellCoord::TConvBuf Buffer;
-        const char * szCoord = CellCoord( m_row_index, FactColumn ).ToString( Buffer );
-        m_XMLWriter->Tag( "c" ).Attr( "r", szCoord ).Attr( "s", style_id ).End( "c" );
-        CheckUsedCells( FactColumn );
-    }
-    ///  empty cell with style   ---
-    m_current_column++;
+    else m_current_column++;
     return * this;
 }
 
@@ -267,37 +496,376 @@ CWorksheet & CWorksheet::AddCell( const char * value, size_t style_id )
 // ****************************************************************************
 CWorksheet & CWorksheet::AddCell( const CellDataTime & data )
 {
-    return AddCellRoutineTempl( data.XlsxValue(), data.style_id, GetCellCoordStrAndCheckUsedCellsAndIncColumn(), * m_XMLWriter, this );
+    return AddCellValue( data.XlsxValue(), data.style_id );
 }
 
 CWorksheet & CWorksheet::AddCell( int32_t value, size_t style_id )
 {
-    return AddCellRoutineTempl( value, style_id, GetCellCoordStrAndCheckUsedCellsAndIncColumn(), * m_XMLWriter, this );
+    return AddCellValue( value, style_id );
 }
 
 CWorksheet & CWorksheet::AddCell( uint32_t value, size_t style_id )
 {
-    return AddCellRoutineTempl( value, style_id, GetCellCoordStrAndCheckUsedCellsAndIncColumn(), * m_XMLWriter, this );
+    return AddCellValue( value, style_id );
 }
 
 CWorksheet & CWorksheet::AddCell( int64_t value, size_t style_id )
 {
-    return AddCellRoutineTempl( value, style_id, GetCellCoordStrAndCheckUsedCellsAndIncColumn(), * m_XMLWriter, this );
+    return AddCellValue( value, style_id );
 }
 
 CWorksheet & CWorksheet::AddCell( uint64_t value, size_t style_id )
 {
-    return AddCellRoutineTempl( value, style_id, GetCellCoordStrAndCheckUsedCellsAndIncColumn(), * m_XMLWriter, this );
+    return AddCellValue( value, style_id );
 }
 
 CWorksheet & CWorksheet::AddCell( float value, size_t style_id )
 {
-    return AddCellRoutineTempl( value, style_id, GetCellCoordStrAndCheckUsedCellsAndIncColumn(), * m_XMLWriter, this );
+    return AddCellValue( value, style_id );
 }
 
 CWorksheet & CWorksheet::AddCell( double value, size_t style_id )
 {
-    return AddCellRoutineTempl( value, style_id, GetCellCoordStrAndCheckUsedCellsAndIncColumn(), * m_XMLWriter, this );
+    return AddCellValue( value, style_id );
+}
+
+CWorksheet & CWorksheet::AddDecimalCell( double value, int decimals, size_t style_id )
+{
+    BeginCell( style_id );
+    m_XMLWriter->Lit( CellValue );
+    WriteDecimal( value, decimals );
+    m_XMLWriter->Lit( CellValueEnd );
+    return * this;
+}
+
+// ****************************************************************************
+/// @brief	Chooses the storage of the string in the column with STRINGS_AUTO mode
+/// @param	Col column index (starts from 0)
+/// @param	value pointer to the string
+/// @param	len length of the string
+/// @return	STRINGS_SHARED or STRINGS_INLINE
+/// @note	The first strings of the column are shared. Then the choice is made again each time the number
+///         of the strings doubles: the column is inline while more than half of its strings are distinct
+// ****************************************************************************
+EStringMode CWorksheet::AutoStringMode( uint32_t Col, const char * value, size_t len )
+{
+    AutoStringColumn & Column = m_autoStrings[ Col ];
+    Column.Distinct.Add( value, len );
+    if( ++Column.Count == Column.NextCheck )
+    {
+        Column.Mode = ( Column.Distinct.Estimate() * 2 > Column.Count ) ? STRINGS_INLINE : STRINGS_SHARED;
+        Column.NextCheck *= 2;
+    }
+    return Column.Mode;
+}
+
+// ****************************************************************************
+/// @brief	Returns the storage of the strings chosen for the columns with STRINGS_AUTO mode
+/// @return	Statistics of the columns in ascending order
+// ****************************************************************************
+std::vector<StringColumnStats> CWorksheet::GetStringStats() const
+{
+    std::vector<StringColumnStats> Result;
+    Result.reserve( m_autoStrings.size() );
+    for( std::map<uint32_t, AutoStringColumn>::const_iterator it = m_autoStrings.begin(); it != m_autoStrings.end(); it++ )
+    {
+        const StringColumnStats Stats = { it->first, it->second.Mode, it->second.Count, it->second.Distinct.Estimate() };
+        Result.push_back( Stats );
+    }
+    return Result;
+}
+
+// ****************************************************************************
+/// @brief	Add cell with the registered shared string
+/// @param	value handle of the string
+/// @param	style_id style index
+/// @return	Reference to this object
+// ****************************************************************************
+CWorksheet & CWorksheet::AddCell( SharedStringHandle value, size_t style_id )
+{
+    assert( ! value.IsValid() || ( m_localStrings == NULL ) || ( value.Index() < m_sharedBase ) );   // registered before the sheet is added
+    if( ! value.IsValid() || ( ( m_localStrings != NULL ) && ( value.Index() >= m_sharedBase ) ) )
+        return AddStringCell( "", 0, style_id, STRINGS_DEFAULT );
+    BeginCell( style_id );
+    m_XMLWriter->Lit( CellSharedStr ).Lit( CellValue ).Value( value.Index() ).Lit( CellValueEnd );
+    return * this;
+}
+
+// ****************************************************************************
+/// @brief	Writes the type and the value of the string cell which beginning is written
+/// @param	value pointer to the string
+/// @param	len length of the string
+/// @param	mode storage of the string (STRINGS_SHARED or STRINGS_INLINE)
+/// @return	no
+// ****************************************************************************
+inline void CWorksheet::AddStringValue( const char * value, size_t len, EStringMode mode )
+{
+    if( mode == STRINGS_INLINE )
+        m_XMLWriter->Lit( CellInlineStr ).Text( value, len ).Lit( CellInlineStrEnd );
+    else m_XMLWriter->Lit( CellSharedStr ).Lit( CellValue ).Value( SharedStringIndex( value, len ) ).Lit( CellValueEnd );
+}
+
+// ****************************************************************************
+/// @brief	Returns the index of the string in the shared strings, adds the string if it is new
+/// @param	value pointer to the string
+/// @param	len length of the string
+/// @return	Index of the string
+// ****************************************************************************
+uint64_t CWorksheet::SharedStringIndex( const char * value, size_t len )
+{
+    assert( m_sharedStrings != NULL );
+    return m_sharedBase + m_sharedStrings->Add( value, len );
+}
+
+// ****************************************************************************
+/// @brief	Makes the sheet collect its strings in the own table, so it can be filled in a separate thread
+/// @param	base number of the strings of the workbook (registered strings)
+/// @return	no
+// ****************************************************************************
+void CWorksheet::UseLocalSharedStr( uint64_t base )
+{
+    assert( m_localStrings == NULL );
+    m_localStrings = new SharedStringTable();
+    m_sharedStrings = m_localStrings;
+    m_sharedBase = base;
+}
+
+// ****************************************************************************
+/// @brief	Adds the own strings of the sheet into the shared strings of the workbook
+/// @param	shared shared strings of the workbook
+/// @return	no
+/// @note	The sheets are merged in their order, so the indexes do not depend on the threads.
+///         The written indexes are replaced by RemapIndexes if they differ from the final ones.
+// ****************************************************************************
+void CWorksheet::MergeSharedStrings( SharedStringTable & shared )
+{
+    if( m_localStrings == NULL )
+        return;
+    bool Same = true;
+    m_sharedRemap.resize( m_localStrings->Size() );
+    for( size_t i = 0; i < m_sharedRemap.size(); i++ )
+    {
+        m_sharedRemap[ i ] = shared.Add( m_localStrings->String( i ), m_localStrings->Length( i ) );
+        Same = Same && ( m_sharedRemap[ i ] == m_sharedBase + i );
+    }
+    if( Same )
+        m_sharedRemap.clear();
+    delete m_localStrings;
+    m_localStrings = NULL;
+    m_sharedStrings = NULL;
+}
+
+// ****************************************************************************
+/// @brief	Adds the style for this sheet if it does not exist yet
+/// @param	style the style
+/// @return	Index of the style for the cells, the rows and the columns of this sheet
+/// @note	The own style of the sheet filled in parallel gets the temporary index, it is replaced
+///         by the index of the workbook style at saving
+// ****************************************************************************
+size_t CWorksheet::AddStyle( const Style & style )
+{
+    assert( m_styleList != NULL );
+    const size_t Index = m_styleList->Add( style );
+    if( m_localStyleList == NULL )
+        return Index;
+    if( Index == m_localStyles.size() )
+        m_localStyles.push_back( style );
+    return LocalStyleBase + Index;
+}
+
+// ****************************************************************************
+/// @brief	Makes the sheet collect its styles in the own list, so it can be filled in a separate thread
+/// @return	no
+// ****************************************************************************
+void CWorksheet::UseLocalStyles()
+{
+    assert( m_localStyleList == NULL );
+    m_localStyleList = new StyleList();
+    m_styleList = m_localStyleList;
+}
+
+// ****************************************************************************
+/// @brief	Adds the own styles of the sheet into the styles of the workbook
+/// @param	styles styles of the workbook
+/// @return	no
+/// @note	The sheets are merged in their order, so the indexes do not depend on the threads.
+///         The written indexes are replaced by RemapIndexes.
+// ****************************************************************************
+void CWorksheet::MergeStyles( StyleList & styles )
+{
+    if( m_localStyleList == NULL )
+        return;
+    m_styleRemap.resize( m_localStyles.size() );
+    for( size_t i = 0; i < m_styleRemap.size(); i++ )
+        m_styleRemap[ i ] = styles.Add( m_localStyles[ i ] );
+    std::vector<Style>().swap( m_localStyles );
+    delete m_localStyleList;
+    m_localStyleList = NULL;
+    m_styleList = NULL;
+}
+
+// ****************************************************************************
+/// @brief	Opens the row for RowWriter
+/// @param	Size number of the cells
+/// @param	Offset the offset from the row begining
+/// @param	RowIndex index of the row (starts from 1)
+/// @return	no
+// ****************************************************************************
+void CWorksheet::BeginFixedRow( size_t Size, uint32_t Offset, uint32_t RowIndex )
+{
+    EndRow();
+    m_offset_column = Offset;
+    AddRowHeader( Size, 0.0, RowIndex );
+    m_current_column = 0;
+}
+
+void CWorksheet::EndFixedRow()
+{
+    AddRowFooter();
+    m_offset_column = 0;
+}
+
+template<typename T>
+inline void CWorksheet::AddFixedCellValue( T value, const CellStyleAttr & style )
+{
+    const uint32_t Col = m_offset_column + m_current_column;
+    BeginCell( style );
+    m_XMLWriter->Lit( CellValue );
+    WriteNumber( value, Col );
+    m_XMLWriter->Lit( CellValueEnd );
+}
+
+// *INDENT-OFF*   For AStyle tool
+void CWorksheet::AddFixedCell( int32_t value, const CellStyleAttr & style )             { AddFixedCellValue( value, style ); }
+void CWorksheet::AddFixedCell( uint32_t value, const CellStyleAttr & style )            { AddFixedCellValue( value, style ); }
+void CWorksheet::AddFixedCell( int64_t value, const CellStyleAttr & style )             { AddFixedCellValue( value, style ); }
+void CWorksheet::AddFixedCell( uint64_t value, const CellStyleAttr & style )            { AddFixedCellValue( value, style ); }
+void CWorksheet::AddFixedCell( float value, const CellStyleAttr & style )               { AddFixedCellValue( value, style ); }
+void CWorksheet::AddFixedCell( double value, const CellStyleAttr & style )              { AddFixedCellValue( value, style ); }
+void CWorksheet::AddFixedCell( const CellDataTime & value, const CellStyleAttr & style ) { AddFixedCellValue( value.XlsxValue(), style ); }
+// *INDENT-ON*   For AStyle tool
+
+void CWorksheet::AddFixedString( const char * value, size_t len, const CellStyleAttr & style )
+{
+    if( ( len == 0 ) || ( value[ 0 ] == '=' ) )     // empty cells and formulae
+    {
+        AddStringCell( value, len, style.style_id, STRINGS_DEFAULT );
+        return;
+    }
+    const EStringMode CellMode = StringMode( m_offset_column + m_current_column, STRINGS_DEFAULT, value, len );
+    BeginCell( style );
+    AddStringValue( value, len, CellMode );
+}
+
+// ****************************************************************************
+/// @brief	Appends the block of rows from the arrays of values
+/// @param	columns descriptions of the columns
+/// @param	columnCount number of the columns
+/// @param	rowCount number of the rows to add
+/// @param	offset the offset from the row begining (0 by default)
+/// @return	Reference to this object
+/// @note	The cell writer is chosen once per column, so the loop over the rows does not check the types.
+///         The rows are written by chunks, the time columns of a chunk are converted to the serials by one call.
+// ****************************************************************************
+CWorksheet & CWorksheet::AddColumns( const ColumnData * columns, size_t columnCount, size_t rowCount, uint32_t offset )
+{
+    EndRow();
+    std::vector<TBlockCellWriter> Writers( columnCount );
+    std::vector<ColumnData> Chunk( columns, columns + columnCount );    //Columns with the values of the current chunk
+    std::vector< std::vector<double> > Serials( columnCount );
+    for( size_t Col = 0; Col < columnCount; Col++ )
+    {
+        const bool IsTime = ( columns[ Col ].type == ColumnData::TYPE_TIME ) || ( columns[ Col ].type == ColumnData::TYPE_TIME_MS );
+        if( IsTime )
+            Serials[ Col ].resize( std::min( BlockChunkRows, rowCount ) );
+        Writers[ Col ] = GetBlockCellWriter( IsTime ? ColumnData::TYPE_DOUBLE : columns[ Col ].type );
+    }
+
+    m_offset_column = offset;
+    for( size_t First = 0; First < rowCount; First += BlockChunkRows )
+    {
+        const size_t Count = std::min( BlockChunkRows, rowCount - First );
+        for( size_t Col = 0; Col < columnCount; Col++ )
+        {
+            const ColumnData & Column = columns[ Col ];
+            if( Column.type == ColumnData::TYPE_TIME )
+                ExcelCalendar::FromTimeT( static_cast<const time_t *>( Column.values ) + First, Count, Serials[ Col ].data() );
+            else if( Column.type == ColumnData::TYPE_TIME_MS )
+                ExcelCalendar::FromEpochMilliseconds( static_cast<const int64_t *>( Column.values ) + First, Count, Serials[ Col ].data() );
+            Chunk[ Col ].values = Serials[ Col ].empty() ? ColumnValues( Column, First ) : Serials[ Col ].data();
+        }
+        for( size_t Row = 0; Row < Count; Row++ )
+        {
+            AddRowHeader( columnCount, 0.0, m_row_index + 1 );
+            m_current_column = 0;
+            for( size_t Col = 0; Col < columnCount; Col++ )
+                ( this->*Writers[ Col ] )( Chunk[ Col ], Row );
+            AddRowFooter();
+        }
+    }
+    m_offset_column = 0;
+    return * this;
+}
+
+const void * CWorksheet::ColumnValues( const ColumnData & Column, size_t Row )
+{
+    size_t Size = 0;
+    switch( Column.type )
+    {
+        case ColumnData::TYPE_INT32 :   Size = sizeof( int32_t );       break;
+        case ColumnData::TYPE_UINT32 :  Size = sizeof( uint32_t );      break;
+        case ColumnData::TYPE_INT64 :   Size = sizeof( int64_t );       break;
+        case ColumnData::TYPE_UINT64 :  Size = sizeof( uint64_t );      break;
+        case ColumnData::TYPE_FLOAT :   Size = sizeof( float );         break;
+        case ColumnData::TYPE_DOUBLE :  Size = sizeof( double );        break;
+        case ColumnData::TYPE_TIME :    Size = sizeof( time_t );        break;
+        case ColumnData::TYPE_TIME_MS : Size = sizeof( int64_t );       break;
+        case ColumnData::TYPE_CSTR :    Size = sizeof( const char * );  break;
+        case ColumnData::TYPE_STRING :  Size = sizeof( std::string );   break;
+        case ColumnData::TYPE_EMPTY :   return Column.values;
+    }
+    return static_cast<const char *>( Column.values ) + Row * Size;
+}
+
+CWorksheet::TBlockCellWriter CWorksheet::GetBlockCellWriter( ColumnData::EType Type )
+{
+    switch( Type )
+    {
+        case ColumnData::TYPE_INT32 :   return & CWorksheet::AddBlockCell<int32_t>;
+        case ColumnData::TYPE_UINT32 :  return & CWorksheet::AddBlockCell<uint32_t>;
+        case ColumnData::TYPE_INT64 :   return & CWorksheet::AddBlockCell<int64_t>;
+        case ColumnData::TYPE_UINT64 :  return & CWorksheet::AddBlockCell<uint64_t>;
+        case ColumnData::TYPE_FLOAT :   return & CWorksheet::AddBlockCell<float>;
+        case ColumnData::TYPE_DOUBLE :  return & CWorksheet::AddBlockCell<double>;
+        case ColumnData::TYPE_TIME :
+        case ColumnData::TYPE_TIME_MS : break;  //Converted to the serials by AddColumns
+        case ColumnData::TYPE_CSTR :    return & CWorksheet::AddBlockCStr;
+        case ColumnData::TYPE_STRING :  return & CWorksheet::AddBlockString;
+        case ColumnData::TYPE_EMPTY :   break;
+    }
+    return & CWorksheet::AddBlockEmpty;
+}
+
+template<typename T>
+void CWorksheet::AddBlockCell( const ColumnData & Column, size_t Row )
+{
+    AddCellValue( static_cast<const T *>( Column.values )[ Row ], Column.style_id );
+}
+
+void CWorksheet::AddBlockCStr( const ColumnData & Column, size_t Row )
+{
+    const char * Value = static_cast<const char * const *>( Column.values )[ Row ];
+    AddCell( Value != NULL ? Value : "", Column.style_id );
+}
+
+void CWorksheet::AddBlockString( const ColumnData & Column, size_t Row )
+{
+    AddCell( static_cast<const std::string *>( Column.values )[ Row ], Column.style_id );
+}
+
+void CWorksheet::AddBlockEmpty( const ColumnData &, size_t )
+{
+    m_current_column++;
 }
 
 // ****************************************************************************
@@ -339,26 +907,56 @@ void CWorksheet::AddFrozenPane( uint32_t width, uint32_t height )
         m_XMLWriter->TagL( "selection" ).Attr( "pane", "bottomLeft" ).Attr( "activeCell", szCoord ).Attr( "sqref", szCoord ).EndL();
 }
 
-void CWorksheet::AddRowHeader( std::size_t Size, double Height )
+void CWorksheet::AddRowHeader( std::size_t Size, double Height, uint32_t RowIndex )
 {
-    std::stringstream Spans;
-    Spans << m_offset_column + 1 << ':' << Size + m_offset_column + 1;
-    m_XMLWriter->Tag( "row" ).Attr( "r", ++m_row_index ).Attr( "spans", Spans.str() ).Attr( "x14ac:dyDescent", 0.25 );
-    if( Height > 0 )
+    CommitUsedCells();
+    SetRowIndex( NextRowIndex( RowIndex ) );
+    if( ! m_sheetDataOpened )
+        OpenSheetData();
+    m_XMLWriter->Tag( "row" ).Attr( "r", m_RowRef, m_RowRefLen );
+    if( ! m_compact )
+    {
+        char Spans[ 2 * NumberToChars::BufferSize ];
+        size_t SpansLen = NumberToChars::UInt( m_offset_column + 1, Spans );
+        Spans[ SpansLen++ ] = ':';
+        SpansLen += NumberToChars::UInt( Size + m_offset_column + 1, Spans + SpansLen );
+        m_XMLWriter->Attr( "spans", Spans, SpansLen ).Lit( RowDescent );
+    }
+    AddRowAttributes( Height );
+}
+
+// ****************************************************************************
+/// @brief	Writes the optional attributes of the row being opened
+/// @param	Height row height (default if 0)
+/// @return	no
+// ****************************************************************************
+void CWorksheet::AddRowAttributes( double Height )
+{
+    if( Height > 0.0 )
         m_XMLWriter->Attr( "ht", Height ).Attr( "customHeight", 1 );
+    if( m_rowStyle != 0 )
+        m_XMLWriter->Attr( "s", m_rowStyle ).Attr( "customFormat", 1 );
 }
 
-void CWorksheet::AddRowFooter() const
+void CWorksheet::AddRowFooter()
 {
     m_XMLWriter->End( "row" );
+    CommitUsedCells();
 }
 
-void CWorksheet::CheckUsedCells( uint32_t Col )
+// ****************************************************************************
+/// @brief  Extends the used range by the cells of the current row
+/// @return no
+// ****************************************************************************
+void CWorksheet::CommitUsedCells()
 {
+    if( m_RowFirstUsedCol == NoColumn )
+        return;
     m_UsedCellFirst.row = (std::min)( m_UsedCellFirst.row, m_row_index );
-    m_UsedCellFirst.col = (std::min)( m_UsedCellFirst.col, Col );
+    m_UsedCellFirst.col = (std::min)( m_UsedCellFirst.col, m_RowFirstUsedCol );
     m_UsedCellLast.row = (std::max)( m_UsedCellLast.row, m_row_index );
-    m_UsedCellLast.col = (std::max)( m_UsedCellLast.col, Col );
+    m_UsedCellLast.col = (std::max)( m_UsedCellLast.col, m_RowLastUsedCol );
+    m_RowFirstUsedCol = m_RowLastUsedCol = NoColumn;
 }
 
 // ****************************************************************************
@@ -374,6 +972,98 @@ CWorksheet & CWorksheet::MergeCells( CellCoord cellFrom, CellCoord cellTo )
     return * this;
 }
 
+// ****************************************************************************
+/// @brief  Appends conditional formatting rule of the range
+/// @param  cellFrom (row value from 1, col value from 0)
+/// @param  cellTo (row value from 1, col value from 0)
+/// @param  rule the rule (skipped if ConditionalRule::IsValid fails)
+/// @return Reference to this object
+// ****************************************************************************
+CWorksheet & CWorksheet::AddConditionalFormat( CellCoord cellFrom, CellCoord cellTo, const ConditionalRule & rule )
+{
+    assert( rule.IsValid() );
+    if( ( cellFrom.row != 0 ) && ( cellTo.row != 0 ) && rule.IsValid() )
+        m_conditionalFormats.push_back( std::make_pair( cellFrom.ToString() + ':' + cellTo.ToString(), rule ) );
+    return * this;
+}
+
+// ****************************************************************************
+/// @brief  Writes conditionalFormatting elements, the rules of the same range are joined
+/// @return no
+// ****************************************************************************
+void CWorksheet::AddConditionalFormats()
+{
+    for( size_t i = 0; i < m_conditionalFormats.size(); )
+    {
+        const std::string & Range = m_conditionalFormats[ i ].first;
+        m_XMLWriter->Tag( "conditionalFormatting" ).Attr( "sqref", Range );
+        for( ; ( i < m_conditionalFormats.size() ) && ( m_conditionalFormats[ i ].first == Range ); i++ )
+            AddConditionalRule( m_conditionalFormats[ i ].second, i + 1 );
+        m_XMLWriter->End( "conditionalFormatting" );
+    }
+}
+
+// ****************************************************************************
+/// @brief  Writes cfRule element
+/// @param  rule the rule
+/// @param  priority priority of the rule in the sheet (from 1)
+/// @return no
+// ****************************************************************************
+void CWorksheet::AddConditionalRule( const ConditionalRule & rule, size_t priority )
+{
+    static const char * const Types[] = { "cellIs", "expression", "colorScale", "dataBar" };
+    static const char * const Operators[] =
+    { "lessThan", "lessThanOrEqual", "equal", "notEqual", "greaterThanOrEqual", "greaterThan", "between", "notBetween" };
+    static const char * const ValueTypes[] = { "min", "max", "num", "percent", "percentile", "formula" };
+
+    m_XMLWriter->Tag( "cfRule" ).Attr( "type", Types[ rule.type ] );
+    if( ( rule.type == ConditionalRule::CELL_IS ) || ( rule.type == ConditionalRule::EXPRESSION ) )
+        m_XMLWriter->Attr( "dxfId", rule.dxfId );
+    m_XMLWriter->Attr( "priority", priority );
+    if( rule.stopIfTrue )
+        m_XMLWriter->Attr( "stopIfTrue", 1 );
+    switch( rule.type )
+    {
+        case ConditionalRule::CELL_IS:
+            m_XMLWriter->Attr( "operator", Operators[ rule.op ] );
+            AddConditionalFormula( rule.formula1 );
+            if( ( rule.op == COND_BETWEEN ) || ( rule.op == COND_NOT_BETWEEN ) )
+                AddConditionalFormula( rule.formula2 );
+            break;
+        case ConditionalRule::EXPRESSION:
+            AddConditionalFormula( rule.formula1 );
+            break;
+        case ConditionalRule::COLOR_SCALE:
+        case ConditionalRule::DATA_BAR:
+        {
+            const bool IsScale = rule.type == ConditionalRule::COLOR_SCALE;
+            m_XMLWriter->Tag( IsScale ? "colorScale" : "dataBar" );
+            for( std::vector<ConditionalRule::Threshold>::const_iterator it = rule.thresholds.begin(); it != rule.thresholds.end(); it++ )
+            {
+                m_XMLWriter->TagL( "cfvo" ).Attr( "type", ValueTypes[ it->type ] );
+                if( ( it->type != COND_VALUE_MIN ) && ( it->type != COND_VALUE_MAX ) )
+                    m_XMLWriter->Attr( "val", it->value );
+                m_XMLWriter->EndL();
+            }
+            if( IsScale )
+            {
+                for( std::vector<ConditionalRule::Threshold>::const_iterator it = rule.thresholds.begin(); it != rule.thresholds.end(); it++ )
+                    m_XMLWriter->TagL( "color" ).Attr( "rgb", it->color.ToString() ).EndL();
+            }
+            else m_XMLWriter->TagL( "color" ).Attr( "rgb", rule.barColor.ToString() ).EndL();
+            m_XMLWriter->End( IsScale ? "colorScale" : "dataBar" );
+            break;
+        }
+    }
+    m_XMLWriter->End( "cfRule" );
+}
+
+void CWorksheet::AddConditionalFormula( const std::string & formula )
+{
+    const size_t Skip = ( ! formula.empty() && ( formula[ 0 ] == '=' ) ) ? 1 : 0;
+    m_XMLWriter->TagOnlyContent( "formula", formula.data() + Skip, formula.size() - Skip );
+}
+
 // ****************************************************************************
 ///	@brief	Receives next to write cell`s coordinates
 /// @param	currCell (row value from 1, col value from 0)
@@ -392,6 +1082,9 @@ const CWorksheet & CWorksheet::GetCurrentCellCoord( CellCoord & currCell ) const
 // ****************************************************************************
 bool CWorksheet::Save()
 {
+    CommitUsedCells();
+    if( ! m_sheetDataOpened )
+        OpenSheetData();
     m_XMLWriter->End( "sheetData" );    // close sheetData tag
 
     if( ! m_mergedCells.empty() )
@@ -401,6 +1094,7 @@ bool CWorksheet::Save()
             m_XMLWriter->TagL( "mergeCell" ).Attr( "ref", * it ).EndL();
         m_XMLWriter->End( "mergeCells" );
     }
+    AddConditionalFormats();
     std::string sOrient;
     if( m_page_orientation == PAGE_PORTRAIT ) sOrient = "portrait";
     else if( m_page_orientation == PAGE_LANDSCAPE ) sOrient = "landscape";
@@ -434,7 +1128,7 @@ bool CWorksheet::Save()
     if( ( rId != 1 ) && ! SaveSheetRels() )
         return false;
     m_isOk = false;
-    return UpdateTableDimension();
+    return UpdateTableDimension() && RemapIndexes();
 }
 
 bool CWorksheet::UpdateTableDimension()
@@ -447,8 +1141,8 @@ bool CWorksheet::UpdateTableDimension()
         if( ! f.is_open() )
             return false;
         f.seekp( m_DimensionOffset );
-        const std::string ResDim = m_UsedCellFirst.ToString() + ":" + m_UsedCellLast.ToString() + '\"';
-        f.write( ResDim.c_str(), ResDim.size() );
+        CellCoord::TConvBuf First, Last;
+        f << m_UsedCellFirst.ToString( First ) << ':' << m_UsedCellLast.ToString( Last ) << '\"';
     }
     catch( ... )
     {
@@ -457,6 +1151,99 @@ bool CWorksheet::UpdateTableDimension()
     return true;
 }
 
+// ****************************************************************************
+/// @brief	Replaces the indexes of the own strings and styles written into the sheet by their final indexes
+/// @return	Boolean result of the operation
+/// @note	The file is copied by blocks. The sequences t="s"><v>, s=" and style=" are written only
+///         by the shared string cells and the style attributes (quotes and '>' in the texts are escaped).
+// ****************************************************************************
+bool CWorksheet::RemapIndexes()
+{
+    if( m_sharedRemap.empty() && m_styleRemap.empty() )
+        return true;
+    enum { MarkerString, MarkerCellStyle, MarkerColumnStyle, MarkerCount };
+    const std::string Markers[ MarkerCount ] = { std::string( CellSharedStr ) + CellValue, CellStyleBegin, " style=\"" };
+    size_t MaxMarkerSize = 0;
+    for( size_t m = 0; m < MarkerCount; m++ )
+        MaxMarkerSize = std::max( MaxMarkerSize, Markers[ m ].size() );
+    const std::string RemapFileName = m_FileName + ".remap";
+    try
+    {
+        std::ifstream In( m_FileName.c_str(), std::ios::binary );
+        std::ofstream Out( RemapFileName.c_str(), std::ios::binary | std::ios::trunc );
+        if( ! In.is_open() || ! Out.is_open() )
+            return false;
+        std::vector<char> Block( RemapBlockSize );
+        std::string Data;
+        for( bool Eof = false; ! Eof; )
+        {
+            In.read( & Block[ 0 ], Block.size() );
+            Data.append( & Block[ 0 ], static_cast<size_t>( In.gcount() ) );
+            Eof = ! In;
+            size_t Done = 0;    // Data[ 0, Done ) is written
+            size_t Next[ MarkerCount ];     // The next positions of the markers, each is searched again after it is passed
+            Next[ MarkerString ] = m_sharedRemap.empty() ? std::string::npos : Data.find( Markers[ MarkerString ] );
+            Next[ MarkerCellStyle ] = m_styleRemap.empty() ? std::string::npos : Data.find( Markers[ MarkerCellStyle ] );
+            Next[ MarkerColumnStyle ] = m_styleRemap.empty() ? std::string::npos : Data.find( Markers[ MarkerColumnStyle ] );
+            for( ;; )
+            {
+                size_t Kind = MarkerString;
+                for( size_t m = 0; m < MarkerCount; m++ )
+                    if( Next[ m ] < Next[ Kind ] )
+                        Kind = m;
+                const size_t Pos = Next[ Kind ];
+                if( Pos == std::string::npos )
+                {
+                    // The tail may be the beginning of a marker
+                    const size_t Keep = Eof ? 0 : std::min( Data.size() - Done, MaxMarkerSize - 1 );
+                    Out.write( Data.data() + Done, Data.size() - Done - Keep );
+                    Done = Data.size() - Keep;
+                    break;
+                }
+                size_t End = Pos + Markers[ Kind ].size();
+                uint64_t Index = 0;
+                for( ; ( End < Data.size() ) && ( Data[ End ] >= '0' ) && ( Data[ End ] <= '9' ); End++ )
+                    Index = Index * 10 + static_cast<uint64_t>( Data[ End ] - '0' );
+                if( ( End == Data.size() ) && ! Eof )   // The index continues in the next block
+                {
+                    Out.write( Data.data() + Done, Pos - Done );
+                    Done = Pos;
+                    break;
+                }
+                if( Kind == MarkerString )
+                {
+                    if( Index >= m_sharedBase )     // Not a registered string
+                    {
+                        assert( Index - m_sharedBase < m_sharedRemap.size() );
+                        if( Index - m_sharedBase < m_sharedRemap.size() )
+                            Index = m_sharedRemap[ Index - m_sharedBase ];
+                    }
+                }
+                else if( Index >= LocalStyleBase )  // Own style of the sheet
+                {
+                    assert( Index - LocalStyleBase < m_styleRemap.size() );
+                    Index = ( Index - LocalStyleBase < m_styleRemap.size() ) ? m_styleRemap[ Index - LocalStyleBase ] : 0;
+                }
+                char Buffer[ NumberToChars::BufferSize ];
+                Out.write( Data.data() + Done, Pos + Markers[ Kind ].size() - Done );
+                Out.write( Buffer, NumberToChars::UInt( Index, Buffer ) );
+                Done = End;
+                Next[ Kind ] = Data.find( Markers[ Kind ], End );
+            }
+            Data.erase( 0, Done );
+        }
+        Out.close();
+        if( ! Out )
+            return false;
+    }
+    catch( ... )
+    {
+        return false;
+    }
+    std::remove( m_FileName.c_str() );
+    return std::rename( RemapFileName.c_str(), m_FileName.c_str() ) == 0;
+}
+
 // ****************************************************************************
 /// @brief  Saves current sheet relations file
 /// @return no
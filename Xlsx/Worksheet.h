@@ -22,12 +22,17 @@
 #ifndef XLSX_WORKSHEET_H
 #define XLSX_WORKSHEET_H
 
+#include <array>
+#include <cstring>
 #include <list>
 #include <map>
+#include <mutex>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "SimpleXlsxDef.h"
+#include "SharedStrings.h"
 
 namespace SimpleXlsx
 {
@@ -35,6 +40,38 @@ class CDrawing;
 
 class PathManager;
 class XMLWriter;
+template< typename... Ts > class RowWriter;
+
+// ****************************************************************************
+/// @brief	Storage of the strings of the column with STRINGS_AUTO mode, see CWorksheet::GetStringStats
+// ****************************************************************************
+struct StringColumnStats
+{
+    uint32_t    column;     ///< column index (starts from 0)
+    EStringMode mode;       ///< current storage of the strings: STRINGS_SHARED or STRINGS_INLINE
+    uint64_t    strings;    ///< number of the strings written
+    uint64_t    distinct;   ///< estimated number of the distinct strings
+};
+
+// ****************************************************************************
+/// @brief	Style attribute of the cell rendered once, see RowWriter
+// ****************************************************************************
+class CellStyleAttr
+{
+    public:
+        size_t  style_id;
+        char    text[ 32 ];     ///< " s=\"N\"" or nothing for the default style
+        size_t  len;
+
+        CellStyleAttr( size_t _style_id = 0 ) : style_id( _style_id ), len( 0 )
+        {
+            if( style_id == 0 )     // default style is not necessary to sign explicitly
+                return;
+            std::memcpy( text, " s=\"", 4 );
+            len = 4 + NumberToChars::UInt( style_id, text + 4 );
+            text[ len++ ] = '"';
+        }
+};
 
 // ****************************************************************************
 /// @brief	The class CWorksheet is used for creation and population
@@ -53,9 +90,19 @@ class CWorksheet : public CSheet
         std::string             m_FileName;         ///< file name of the destination xml
         XMLWriter       *       m_XMLWriter;        ///< xml output stream
         std::vector<std::string>m_calcChain;        ///< list of cells with formulae
-        std::map<std::string, uint64_t> * m_sharedStrings; ///< pointer to the list of string supposed to be into shared area
+        std::string             m_wideText;         ///< reused UTF-8 text of the last wide string cell
+        SharedStringTable *     m_sharedStrings;    ///< pointer to the table of strings supposed to be into shared area
+        SharedStringTable *     m_localStrings;     ///< own strings of the sheet filled in parallel, merged at saving
+        uint64_t                m_sharedBase;       ///< index written for the first own string (registered strings are below)
+        std::vector<uint64_t>   m_sharedRemap;      ///< final indexes of the own strings (empty if they are the same)
+        StyleList       *       m_styleList;        ///< styles of the workbook, or the own styles of the sheet filled in parallel
+        StyleList       *       m_localStyleList;   ///< own styles of the sheet filled in parallel, merged at saving
+        std::vector<Style>      m_localStyles;      ///< own styles in the order of their indexes
+        std::vector<size_t>     m_styleRemap;       ///< final indexes of the own styles
         std::vector<Comment> *	m_comments;         ///< pointer to the vector of comments
+        std::mutex       *      m_commentsLock;     ///< guards m_comments shared by the sheets
         std::list<std::string>  m_mergedCells;      ///< list of merged cells` ranges (e.g. A1:B2)
+        std::vector< std::pair<std::string, ConditionalRule> > m_conditionalFormats;   ///< ranges and their rules in the order of priority
         UniString             	m_title;            ///< page title
         bool                    m_withFormula;      ///< indicates whether the sheet contains formulae
         bool					m_withComments;		///< indicates whether the sheet contains any comments
@@ -63,12 +110,38 @@ class CWorksheet : public CSheet
         bool                    m_isDataPresented;  ///< indicates whether the sheet contains a data
         uint32_t				m_row_index;        ///< since data add row-by-row it contains current row to write
         bool					m_row_opened;		///< indicates whether row tag is opened
+        bool                    m_sheetDataOpened;  ///< indicates whether cols and sheetData have been written
+        bool                    m_compact;          ///< compact output profile (see SetCompactOutput)
+        size_t                  m_rowStyle;         ///< default style of the following rows (0 - none)
+        std::vector<size_t>     m_columnStyles;     ///< default styles of the columns (0 - none)
+        EStringMode             m_stringMode;       ///< storage of the strings of the sheet
+        std::vector<EStringMode> m_columnStringModes;///< storage of the strings of the columns (STRINGS_DEFAULT - as the sheet)
+        std::vector<int8_t>     m_columnDecimals;   ///< digits after the point of the floating point values of the columns (-1 - all)
+
+        struct AutoStringColumn
+        {
+            StringCardinality   Distinct;
+            uint64_t            Count;
+            uint64_t            NextCheck;  ///< the mode is chosen again when Count reaches it
+            EStringMode         Mode;
+
+            AutoStringColumn() : Count( 0 ), NextCheck( AutoSampleSize ), Mode( STRINGS_SHARED ) {}
+        };
+        static const uint64_t   AutoSampleSize = 256;
+        std::map<uint32_t, AutoStringColumn> m_autoStrings; ///< columns with STRINGS_AUTO mode
+        std::vector<ColumnWidth> m_colWidths;       ///< column widths to be written before sheetData
         uint32_t				m_current_column;	///< used at separate row generation - last cell column number to be added
         uint32_t				m_offset_column;	///< used at entire row addition (implicit parameter for AddCell method)
 
         std::streamoff          m_DimensionOffset;  ///< offset in bytes for @dimension@ tag in output file
         CellCoord               m_UsedCellFirst;    ///< First used cell with formulas, text content or cell formatting
         CellCoord               m_UsedCellLast;     ///< Last used cell with formulas, text content or cell formatting
+        uint32_t                m_RowFirstUsedCol;  ///< First used column of the current row (NoColumn if none)
+        uint32_t                m_RowLastUsedCol;   ///< Last used column of the current row
+        uint32_t                m_LastWrittenCol;   ///< Column of the last written cell in the current row (NoColumn if none)
+        char                    m_RowRef[ 12 ];     ///< Text of m_row_index, rendered once per row
+        size_t                  m_RowRefLen;        ///< Length of m_RowRef
+        const CellCoord::ColumnName * m_ColumnNames;///< Precomputed column names
 
         EPageOrientation		m_page_orientation;	///< defines page orientation for printing
 
@@ -89,31 +162,69 @@ class CWorksheet : public CSheet
 
         inline CWorksheet & SetPageOrientation( EPageOrientation orient )   { m_page_orientation = orient; return * this; }
 
+        // Compact output: cells that follow the previous one in the row are written without reference,
+        // rows are written without spans and x14ac:dyDescent, empty cells with the default style of
+        // the row or the column (see SetRowStyle, SetColumnStyle) are not written
+        inline CWorksheet & SetCompactOutput( bool compact = true )         { m_compact = compact; return * this; }
+        inline bool IsCompactOutput() const                                 { return m_compact; }
+        // Adds the style if it does not exist yet and returns its index for the cells, rows and columns of this sheet.
+        // With the parallel sheets the sheet keeps its styles until saving (can be called from the thread that
+        // fills the sheet), the returned index is valid only for this sheet. Same as CWorkbook::AddStyle otherwise.
+        size_t AddStyle( const Style & style );
+        // Default style of the following rows, 0 - no style
+        inline CWorksheet & SetRowStyle( size_t style_id )                  { m_rowStyle = style_id; return * this; }
+        // Storage of the following strings of the sheet: shared strings (default) or inline strings.
+        // Inline strings suit the columns with few repeated values (identifiers, URLs, free text):
+        // they are not kept in memory until the workbook is saved
+        inline CWorksheet & SetStringMode( EStringMode mode )               { m_stringMode = mode; return * this; }
+        inline EStringMode GetStringMode() const                            { return m_stringMode; }
+        // Decisions for the columns with STRINGS_AUTO mode
+        std::vector<StringColumnStats> GetStringStats() const;
+
         // *INDENT-ON*   For AStyle tool
 
         CWorksheet & AddComment( const Comment & comment )
         {
             if( m_comments == NULL )
                 return * this;
-            m_comments->push_back( comment );
-            m_comments->back().sheetIndex = m_index;
+            {
+                std::lock_guard<std::mutex> Lock( * m_commentsLock );
+                m_comments->push_back( comment );
+                m_comments->back().sheetIndex = m_index;
+            }
             m_withComments = true;
             return * this;
         }
 
         // *INDENT-OFF*   For AStyle tool
 
-        CWorksheet & BeginRow( double height = 0.0 );
+        CWorksheet & BeginRow( double height = 0.0 )                        { return BeginRowAt( m_row_index + 1, height ); }
+        // Rows must go in ascending order, the skipped rows are not written at all
+        CWorksheet & BeginRowAt( uint32_t rowIndex, double height = 0.0 );
         CWorksheet & EndRow();
 
         inline CWorksheet & AddCell()                                       { m_current_column++; return * this; }
         inline CWorksheet & AddEmptyCells( uint32_t Count )                 { m_current_column += Count; return * this; }
 
-        CWorksheet & AddCell( const char * value, size_t style_id = 0 );
-        CWorksheet & AddCell( const std::string & value, size_t style_id = 0 )  { return AddCell( value.c_str(), style_id ); }
+        // Strings are copied into the shared strings only when they are met first time.
+        // The mode overrides the string mode of the column and the sheet for this cell.
+        CWorksheet & AddCell( const char * value, size_t style_id = 0, EStringMode mode = STRINGS_DEFAULT )
+        { return AddStringCell( value, std::strlen( value ), style_id, mode ); }
+        CWorksheet & AddCell( const std::string & value, size_t style_id = 0, EStringMode mode = STRINGS_DEFAULT )
+        { return AddStringCell( value.data(), value.size(), style_id, mode ); }
+#ifdef SIMPLE_XLSX_STRING_VIEW
+        CWorksheet & AddCell( std::string_view value, size_t style_id = 0, EStringMode mode = STRINGS_DEFAULT )
+        { return AddStringCell( value.data(), value.size(), style_id, mode ); }
+#endif
         inline CWorksheet & AddCell( const CellDataStr & data )                 { return AddCell( data.value, data.style_id ); }
-        CWorksheet & AddCell( const std::wstring & value, size_t style_id = 0 ) { return AddCell( UTF8Encoder::From_wstring( value ), style_id ); }
+        CWorksheet & AddCell( const std::wstring & value, size_t style_id = 0, EStringMode mode = STRINGS_DEFAULT )
+        {
+            UTF8Encoder::Assign( m_wideText, value );
+            return AddStringCell( m_wideText.data(), m_wideText.size(), style_id, mode );
+        }
         inline CWorksheet & AddCells( const std::vector<CellDataStr> & data );
+        // The string registered by CWorkbook::RegisterSharedString, the invalid handle gives an empty cell
+        CWorksheet & AddCell( SharedStringHandle value, size_t style_id = 0 );
 
         CWorksheet & AddCell( const CellDataTime & data );
         inline CWorksheet & AddCells( const std::vector<CellDataTime> & data );
@@ -134,18 +245,43 @@ class CWorksheet : public CSheet
         inline CWorksheet & AddCells( const std::vector<CellDataFlt> & data )   { return AddCellsTempl( data ); }
 
         CWorksheet & AddCell( double value, size_t style_id = 0 );
+        // The value is rounded to the decimals digits after the point (0 to NumberToChars::MaxDecimals)
+        CWorksheet & AddDecimalCell( double value, int decimals, size_t style_id = 0 );
         inline CWorksheet & AddCell( const CellDataDbl & data )                 { return AddCell( data.value, data.style_id ); }
         inline CWorksheet & AddCells( const std::vector<CellDataDbl> & data )   { return AddCellsTempl( data ); }
 
-        CWorksheet & AddRow( const std::vector<CellDataStr> & data, uint32_t offset = 0, double height = 0.0 )  { return AddRowTempl( data, offset, height ); }
-        CWorksheet & AddRow( const std::vector<CellDataTime> & data, uint32_t offset = 0, double height = 0.0 ) { return AddRowTempl( data, offset, height ); }
-        CWorksheet & AddRow( const std::vector<CellDataInt> & data, uint32_t offset = 0, double height = 0.0 )  { return AddRowTempl( data, offset, height ); }
-        CWorksheet & AddRow( const std::vector<CellDataUInt> & data, uint32_t offset = 0, double height = 0.0 ) { return AddRowTempl( data, offset, height ); }
-        CWorksheet & AddRow( const std::vector<CellDataFlt> & data, uint32_t offset = 0, double height = 0.0 )  { return AddRowTempl( data, offset, height ); }
-        CWorksheet & AddRow( const std::vector<CellDataDbl> & data, uint32_t offset = 0, double height = 0.0 )  { return AddRowTempl( data, offset, height ); }
+        CWorksheet & AddRow( const std::vector<CellDataStr> & data, uint32_t offset = 0, double height = 0.0 )  { return AddRowTempl( data, offset, height, m_row_index + 1 ); }
+        CWorksheet & AddRow( const std::vector<CellDataTime> & data, uint32_t offset = 0, double height = 0.0 ) { return AddRowTempl( data, offset, height, m_row_index + 1 ); }
+        CWorksheet & AddRow( const std::vector<CellDataInt> & data, uint32_t offset = 0, double height = 0.0 )  { return AddRowTempl( data, offset, height, m_row_index + 1 ); }
+        CWorksheet & AddRow( const std::vector<CellDataUInt> & data, uint32_t offset = 0, double height = 0.0 ) { return AddRowTempl( data, offset, height, m_row_index + 1 ); }
+        CWorksheet & AddRow( const std::vector<CellDataFlt> & data, uint32_t offset = 0, double height = 0.0 )  { return AddRowTempl( data, offset, height, m_row_index + 1 ); }
+        CWorksheet & AddRow( const std::vector<CellDataDbl> & data, uint32_t offset = 0, double height = 0.0 )  { return AddRowTempl( data, offset, height, m_row_index + 1 ); }
+
+        CWorksheet & AddRowAt( uint32_t rowIndex, const std::vector<CellDataStr> & data, uint32_t offset = 0, double height = 0.0 )  { return AddRowTempl( data, offset, height, rowIndex ); }
+        CWorksheet & AddRowAt( uint32_t rowIndex, const std::vector<CellDataTime> & data, uint32_t offset = 0, double height = 0.0 ) { return AddRowTempl( data, offset, height, rowIndex ); }
+        CWorksheet & AddRowAt( uint32_t rowIndex, const std::vector<CellDataInt> & data, uint32_t offset = 0, double height = 0.0 )  { return AddRowTempl( data, offset, height, rowIndex ); }
+        CWorksheet & AddRowAt( uint32_t rowIndex, const std::vector<CellDataUInt> & data, uint32_t offset = 0, double height = 0.0 ) { return AddRowTempl( data, offset, height, rowIndex ); }
+        CWorksheet & AddRowAt( uint32_t rowIndex, const std::vector<CellDataFlt> & data, uint32_t offset = 0, double height = 0.0 )  { return AddRowTempl( data, offset, height, rowIndex ); }
+        CWorksheet & AddRowAt( uint32_t rowIndex, const std::vector<CellDataDbl> & data, uint32_t offset = 0, double height = 0.0 )  { return AddRowTempl( data, offset, height, rowIndex ); }
+
+        // Appends rowCount rows, the cells of every row are taken from the columns (the row i from the value i of every column)
+        CWorksheet & AddColumns( const ColumnData * columns, size_t columnCount, size_t rowCount, uint32_t offset = 0 );
+        CWorksheet & AddBlock( const std::vector<ColumnData> & columns, size_t rowCount, uint32_t offset = 0 )
+        {
+            return columns.empty() ? * this : AddColumns( & columns[ 0 ], columns.size(), rowCount, offset );
+        }
 
-        CWorksheet & AddEmptyRow( double height = 0.0 ) { return BeginRow( height ).EndRow(); }
-        CWorksheet & AddEmptyRows( size_t count, double height = 0.0 ) { for( size_t i = 0; i < count; ++i ) AddEmptyRow( height ); return * this; }
+        // Empty rows without height and style are only skipped (not written)
+        CWorksheet & AddEmptyRow( double height = 0.0 )                 { return AddEmptyRows( 1, height ); }
+        CWorksheet & AddEmptyRows( size_t count, double height = 0.0 )
+        {
+            if( ( height <= 0.0 ) && ( m_rowStyle == 0 ) )
+                return SkipRows( static_cast<uint32_t>( count ) );
+            for( size_t i = 0; i < count; ++i )
+                BeginRow( height ).EndRow();
+            return * this;
+        }
+        CWorksheet & SkipRows( uint32_t count );
 
         CWorksheet & AddSimpleRow( const CellDataStr & val, uint32_t offset = 0, double height = 0.0 )  { return AddSimpleRow( val.value, val.style_id, offset, height ); }
         CWorksheet & AddSimpleRow( const CellDataInt & val, uint32_t offset = 0, double height = 0.0 )  { return AddSimpleRow( val.value, val.style_id, offset, height ); }
@@ -169,7 +305,27 @@ class CWorksheet : public CSheet
             return BeginRow( height ).AddEmptyCells( offset ).AddCell( val, style_id ).EndRow();
         }
 
+        CWorksheet & SetColumnStyle( uint32_t colFrom, uint32_t colTo, size_t style_id );
+        CWorksheet & SetColumnStringMode( uint32_t colFrom, uint32_t colTo, EStringMode mode );
+        // The following float and double values of the columns are rounded to the decimals digits after the point
+        // (0 to NumberToChars::MaxDecimals, -1 - the shortest text of the exact value)
+        CWorksheet & SetColumnDecimals( uint32_t colFrom, uint32_t colTo, int decimals );
+
+        // Writer of the rows with the fixed types of the cells and the fixed styles, for example:
+        //  RowWriter<std::string, double, int64_t> Writer = sheet.GetRowWriter<std::string, double, int64_t>( { 0, style1, style2 } );
+        //  Writer.Write( "Name", 1.5, 42 );
+        // The style indexes come from AddStyle at run time, so they are rendered once when the writer is made;
+        // the number of the styles is checked at compile time (more styles than columns do not compile).
+        template< typename... Ts >
+        RowWriter<Ts...> GetRowWriter( const std::array<size_t, sizeof...( Ts )> & styles = std::array<size_t, sizeof...( Ts )>(), uint32_t offset = 0 )
+        {
+            return RowWriter<Ts...>( * this, styles, offset );
+        }
+
         CWorksheet & MergeCells( CellCoord cellFrom, CellCoord cellTo );
+        // The rules of the range are applied in the order of adding, the styles are written for a few rules
+        // instead of the styles of every cell (e.g. color scales for heatmaps)
+        CWorksheet & AddConditionalFormat( CellCoord cellFrom, CellCoord cellTo, const ConditionalRule & rule );
 
         const CWorksheet & GetCurrentCellCoord( CellCoord & currCell ) const;
         inline uint32_t CurrentRowIndex() const     { return m_row_index; }
@@ -196,39 +352,189 @@ class CWorksheet : public CSheet
         CWorksheet & operator=( const CWorksheet & );
 
         bool Save();
+        void AddConditionalFormats();
+        void AddConditionalRule( const ConditionalRule & rule, size_t priority );
+        void AddConditionalFormula( const std::string & formula );
         bool UpdateTableDimension();
+        bool RemapIndexes();
 
         // *INDENT-OFF*   For AStyle tool
-        inline void     SetSharedStr( std::map<std::string, uint64_t> * share ) { m_sharedStrings = share; }
-        inline void     SetComments( std::vector<Comment> * share )             { m_comments = share; }
+        inline void     SetSharedStr( SharedStringTable * share )   { m_sharedStrings = share; }
+        inline void     SetStyles( StyleList * styles )             { m_styleList = styles; }
+        inline void     SetComments( std::vector<Comment> * share, std::mutex * lock )  { m_comments = share; m_commentsLock = lock; }
         // *INDENT-ON*   For AStyle tool
+        void UseLocalSharedStr( uint64_t base );
+        void MergeSharedStrings( SharedStringTable & shared );
+        void UseLocalStyles();
+        void MergeStyles( StyleList & styles );
 
         void Init( uint32_t frozenWidth, uint32_t frozenHeight, const std::vector<ColumnWidth> & colHeights );
         void AddFrozenPane( uint32_t width, uint32_t height );
+        void OpenSheetData();
 
         template<typename T>
         CWorksheet & AddCellsTempl( const std::vector<T> & data );
 
-        void AddRowHeader( std::size_t Size, double Height );
-        void AddRowFooter() const;
+        void AddRowHeader( std::size_t Size, double Height, uint32_t RowIndex );
+        void AddRowFooter();
+        void AddRowAttributes( double Height );
 
-        void CheckUsedCells( uint32_t Col );
+        static const uint32_t NoColumn = 0xFFFFFFFF;
+        static const size_t LocalStyleBase = 0x40000000;    // index of the first own style of the sheet filled in parallel
+
+        // *INDENT-OFF*   For AStyle tool
+        inline void     SetRowIndex( uint32_t Row )     { m_row_index = Row; m_RowRefLen = NumberToChars::UInt( Row, m_RowRef ); m_LastWrittenCol = NoColumn; }
+        // Columns only grow inside a row, so the first and the last used cells are enough
+        inline void     UseCell( uint32_t Col )         { if( m_RowFirstUsedCol == NoColumn ) m_RowFirstUsedCol = Col; m_RowLastUsedCol = Col; }
+        // *INDENT-ON*   For AStyle tool
+        void CommitUsedCells();
+
+        // Rows must go in ascending order, otherwise the next row is used
+        inline uint32_t NextRowIndex( uint32_t RowIndex ) const
+        {
+            assert( RowIndex > m_row_index );
+            return RowIndex > m_row_index ? RowIndex : m_row_index + 1;
+        }
 
         template<typename T>
-        CWorksheet & AddRowTempl( const std::vector<T> & data, uint32_t offset, double height );
+        CWorksheet & AddRowTempl( const std::vector<T> & data, uint32_t offset, double height, uint32_t rowIndex );
 
         bool SaveSheetRels();
 
-        inline std::string GetCellCoordStrAndCheckUsedCellsAndIncColumn()
+        // Writes the reference of the cell (e.g. "B12") in the current row, returns its length
+        inline size_t CellRef( uint32_t Col, char * Buffer ) const
         {
-            const uint32_t FactColumn = m_offset_column + m_current_column;
-            std::string Result = CellCoord( m_row_index, FactColumn ).ToString();
-            m_current_column++;
-            CheckUsedCells( FactColumn );
-            return Result;
+            size_t Len;
+            if( Col < CellCoord::MaxCols )
+            {
+                const CellCoord::ColumnName & Name = m_ColumnNames[ Col ];
+                std::memcpy( Buffer, Name.Name, sizeof( Name.Name ) );
+                Len = Name.Len;
+            }
+            else Len = CellCoord::ColumnToString( Col, Buffer );
+            std::memcpy( Buffer + Len, m_RowRef, m_RowRefLen );
+            return Len + m_RowRefLen;
+        }
+
+        // Style of the cell that is not written
+        inline size_t DefaultCellStyle( uint32_t Col ) const
+        {
+            if( m_rowStyle != 0 )
+                return m_rowStyle;
+            return Col < m_columnStyles.size() ? m_columnStyles[ Col ] : 0;
+        }
+
+        inline void BeginCell( size_t style_id );
+        inline void BeginCell( const CellStyleAttr & style );
+        inline void BeginCellRef();
+        uint64_t SharedStringIndex( const char * value, size_t len );
+        CWorksheet & AddStringCell( const char * value, size_t len, size_t style_id, EStringMode mode );
+        inline void AddStringValue( const char * value, size_t len, EStringMode mode );
+
+        EStringMode AutoStringMode( uint32_t Col, const char * value, size_t len );
+
+        // Storage of the string in the column: the mode of the cell, else the mode of the column, else the mode of the sheet
+        inline EStringMode StringMode( uint32_t Col, EStringMode mode, const char * value, size_t len )
+        {
+            if( mode == STRINGS_DEFAULT )
+            {
+                if( ( Col < m_columnStringModes.size() ) && ( m_columnStringModes[ Col ] != STRINGS_DEFAULT ) )
+                    mode = m_columnStringModes[ Col ];
+                else mode = m_stringMode;
+            }
+            return mode == STRINGS_AUTO ? AutoStringMode( Col, value, len ) : mode;
+        }
+
+        template<typename T>
+        CWorksheet & AddCellValue( T data, size_t style_id );
+        template<typename T>
+        inline void WriteNumber( T value, uint32_t Col );
+        inline void WriteNumber( float value, uint32_t Col );
+        inline void WriteNumber( double value, uint32_t Col );
+        inline void WriteDecimal( double value, int decimals );
+
+        typedef void ( CWorksheet::* TBlockCellWriter )( const ColumnData & Column, size_t Row );
+        static TBlockCellWriter GetBlockCellWriter( ColumnData::EType Type );
+        static const void * ColumnValues( const ColumnData & Column, size_t Row );
+        template<typename T>
+        void AddBlockCell( const ColumnData & Column, size_t Row );
+        void AddBlockCStr( const ColumnData & Column, size_t Row );
+        void AddBlockString( const ColumnData & Column, size_t Row );
+        void AddBlockEmpty( const ColumnData & Column, size_t Row );
+
+        // Interface for RowWriter
+        void BeginFixedRow( size_t Size, uint32_t Offset, uint32_t RowIndex );
+        void EndFixedRow();
+        template<typename T>
+        inline void AddFixedCellValue( T value, const CellStyleAttr & style );
+        void AddFixedCell( int32_t value, const CellStyleAttr & style );
+        void AddFixedCell( uint32_t value, const CellStyleAttr & style );
+        void AddFixedCell( int64_t value, const CellStyleAttr & style );
+        void AddFixedCell( uint64_t value, const CellStyleAttr & style );
+        void AddFixedCell( float value, const CellStyleAttr & style );
+        void AddFixedCell( double value, const CellStyleAttr & style );
+        void AddFixedCell( const CellDataTime & value, const CellStyleAttr & style );
+        void AddFixedString( const char * value, size_t len, const CellStyleAttr & style );
+        inline void AddFixedCell( const char * value, const CellStyleAttr & style )          { AddFixedString( value, std::strlen( value ), style ); }
+        inline void AddFixedCell( const std::string & value, const CellStyleAttr & style )   { AddFixedString( value.data(), value.size(), style ); }
+        inline void AddFixedCell( const std::wstring & value, const CellStyleAttr & style )
+        {
+            UTF8Encoder::Assign( m_wideText, value );
+            AddFixedString( m_wideText.data(), m_wideText.size(), style );
         }
 
         friend class CWorkbook;
+        template< typename... Ts > friend class RowWriter;
+};
+
+// ****************************************************************************
+/// @brief	The class RowWriter writes the rows with the cell types fixed at compile time.
+///         The style attributes are rendered once, every Write() call is serialized
+///         by the code generated for the exact types of the columns.
+// ****************************************************************************
+template< typename... Ts >
+class RowWriter
+{
+    public:
+        static const size_t ColumnCount = sizeof...( Ts );
+
+        // Styles of the columns in order, missing styles are default
+        RowWriter( CWorksheet & sheet, const std::array<size_t, sizeof...( Ts )> & styles = std::array<size_t, sizeof...( Ts )>(), uint32_t offset = 0 ) :
+            m_sheet( sheet ), m_offset( offset )
+        {
+            for( size_t i = 0; i < ColumnCount; i++ )
+                m_styles[ i ] = CellStyleAttr( styles[ i ] );
+        }
+
+        // Appends the row after the current one
+        inline RowWriter & Write( const Ts & ... values )
+        {
+            return WriteAt( m_sheet.CurrentRowIndex() + 1, values... );
+        }
+
+        // Appends the row with the given index (see CWorksheet::BeginRowAt)
+        inline RowWriter & WriteAt( uint32_t rowIndex, const Ts & ... values )
+        {
+            m_sheet.BeginFixedRow( ColumnCount, m_offset, rowIndex );
+            WriteCells< 0 >( values... );
+            m_sheet.EndFixedRow();
+            return * this;
+        }
+
+    private:
+        CWorksheet  &   m_sheet;
+        uint32_t        m_offset;
+        CellStyleAttr   m_styles[ ColumnCount > 0 ? ColumnCount : 1 ];
+
+        template< size_t I >
+        inline void WriteCells() {}
+
+        template< size_t I, typename T, typename... Rest >
+        inline void WriteCells( const T & value, const Rest & ... rest )
+        {
+            m_sheet.AddFixedCell( value, m_styles[ I ] );
+            WriteCells< I + 1 >( rest... );
+        }
 };
 
 template<typename T>
@@ -244,13 +550,14 @@ inline CWorksheet & CWorksheet::AddCellsTempl( const std::vector<T> & data )
 /// @param  data reference to the vector of  <T>
 /// @param  offset the offset from the row begining (0 by default)
 /// @param	height row height (default if 0)
+/// @param	rowIndex index of the row (starts from 1), must be greater than the index of the previous row
 /// @return Reference to this object
 // ****************************************************************************
 template<typename T>
-CWorksheet & CWorksheet::AddRowTempl( const std::vector<T> & data, uint32_t offset, double height )
+CWorksheet & CWorksheet::AddRowTempl( const std::vector<T> & data, uint32_t offset, double height, uint32_t rowIndex )
 {
     m_offset_column = offset;
-    AddRowHeader( data.size(), height );
+    AddRowHeader( data.size(), height, rowIndex );
     m_current_column = 0;
     AddCells( data );
     AddRowFooter();
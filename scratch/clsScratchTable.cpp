@@ -129,20 +129,12 @@ size_t clsScratchTable::FindCell(const size_t row,const size_t col, const size_t
    size_t minrow=Cells.front().row; // catch first row index
    size_t maxrow=Cells.back().row; // catch last row index;
    size_t clrow=0;// index of the last treated row in Cells
- if(minrow!=0) sheet.AddEmptyRows(minrow);
-   size_t cnt_empty_rows=0; // counter for delayed insert
+   const size_t firstrow=sheet.CurrentRowIndex()+1; // sheet row for the row 0 of the table
  for(size_t row=minrow;row<=maxrow;++row){
     size_t cl0row=FindRowEntry(row,clrow); // index of row to treat in Cells
-    if(cl0row==Cells.size()){
-     cnt_empty_rows++;  // row not exists, count it to insert later
-     continue;
-    }
-   if(cnt_empty_rows) {
-      sheet.AddEmptyRows(cnt_empty_rows);
-      cnt_empty_rows=0;
-      }
+    if(cl0row==Cells.size()) continue; // row not exists, gaps in the row indexes are not written
 
-   sheet.BeginRow();
+   sheet.BeginRowAt(uint32_t(firstrow+row));
      size_t clmincol=cl0row;
      size_t clmaxcol=FindLastCol(row,cl0row);
      size_t mincol=Cells[clmincol].col;